@@ -5,8 +5,15 @@
 #include <utility>
 #include "moves.hpp"
 #include "board.hpp"
+#include "search.hpp"
 
-// Evaluates the board and chooses the best move for the AI
-std::pair<int, int> select_best_move(Board& board, int player);
+// Static evaluation in centipawns from the player's point of view; uses the
+// network when one is loaded and enabled, the classical tables otherwise
+int evaluate_board(const Board& board, int player);
+int evaluate_classical(const Position& pos, int player);
+
+// Chooses the best move for the side to move: a book or tablebase move when
+// the loaded book or tables have the position, the search result otherwise
+SearchResult select_best_move(Board& board, const SearchLimits& limits);
 
 #endif // AI_HPP
@@ -0,0 +1,100 @@
+// bitboard.hpp
+#ifndef BITBOARD_HPP
+#define BITBOARD_HPP
+
+#include <cstdint>
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+typedef uint64_t Bitboard;
+
+// Squares are numbered a1 = 0 ... h8 = 63. Board coordinates (x, y) keep the
+// layout used everywhere else: x is the row from the top (0 = rank 8), y the column.
+constexpr int NO_SQUARE = -1;
+
+constexpr int make_square(int x, int y) { return (7 - x) * 8 + y; }
+constexpr int square_row(int square) { return 7 - (square >> 3); }
+constexpr int square_col(int square) { return square & 7; }
+constexpr int square_rank(int square) { return square >> 3; }
+constexpr Bitboard square_bb(int square) { return Bitboard(1) << square; }
+
+constexpr Bitboard RANK_1 = 0xFFULL;
+constexpr Bitboard RANK_8 = RANK_1 << 56;
+constexpr Bitboard FILE_A = 0x0101010101010101ULL;
+constexpr Bitboard FILE_H = FILE_A << 7;
+
+inline int pop_count(Bitboard b) { return __builtin_popcountll(b); }
+inline int lsb(Bitboard b) { return __builtin_ctzll(b); }
+
+// Returns the lowest set square and clears it from the bitboard
+inline int pop_lsb(Bitboard& b)
+{
+    int square = lsb(b);
+    b &= b - 1;
+    return square;
+}
+
+// Attack sets of the stepping pieces and the between/line masks, generated at compile time
+struct StepTables
+{
+    Bitboard knight[64];
+    Bitboard king[64];
+    Bitboard pawn[2][64];
+    Bitboard between[64][64];   // Squares strictly between two aligned squares
+    Bitboard line[64][64];      // Full line through two aligned squares
+};
+
+extern const StepTables STEP_TABLES;
+
+// Slider lookup for one square: the occupancy on the relevant squares (mask)
+// becomes an index into the square's slice of the attack table, through a
+// magic multiply or, in builds for BMI2 (make BMI2=1), a PEXT
+struct Magic
+{
+    Bitboard mask;
+    Bitboard magic;
+    const Bitboard* attacks;
+    int shift;
+
+    unsigned index(Bitboard occupied) const
+    {
+#ifdef __BMI2__
+        return static_cast<unsigned>(_pext_u64(occupied, mask));
+#else
+        return static_cast<unsigned>(((occupied & mask) * magic) >> shift);
+#endif
+    }
+};
+
+// Filled in at startup, before main
+extern Magic BISHOP_MAGICS[64];
+extern Magic ROOK_MAGICS[64];
+
+// Attack sets for a piece standing on a square
+inline Bitboard knight_attacks(int square) { return STEP_TABLES.knight[square]; }
+inline Bitboard king_attacks(int square) { return STEP_TABLES.king[square]; }
+inline Bitboard pawn_attacks(int color, int square) { return STEP_TABLES.pawn[color][square]; }
+
+inline Bitboard bishop_attacks(int square, Bitboard occupied)
+{
+    const Magic& magic = BISHOP_MAGICS[square];
+    return magic.attacks[magic.index(occupied)];
+}
+
+inline Bitboard rook_attacks(int square, Bitboard occupied)
+{
+    const Magic& magic = ROOK_MAGICS[square];
+    return magic.attacks[magic.index(occupied)];
+}
+
+inline Bitboard queen_attacks(int square, Bitboard occupied)
+{
+    return bishop_attacks(square, occupied) | rook_attacks(square, occupied);
+}
+
+// Squares strictly between two aligned squares, and the full line through them (0 if not aligned)
+inline Bitboard between_bb(int from, int to) { return STEP_TABLES.between[from][to]; }
+inline Bitboard line_bb(int from, int to) { return STEP_TABLES.line[from][to]; }
+
+#endif // BITBOARD_HPP
@@ -3,49 +3,72 @@
 #define BOARD_HPP
 
 #include <vector>
+#include <array>
+#include <string>
+#include <unordered_map>
 #include <iostream>
 #include <iomanip>
 #include <algorithm>
-#include <chrono> // for timestamps
 #include "moves.hpp"
 #include "piece.hpp"
+#include "position.hpp"
+#include "packed.hpp"
+#include "history.hpp"
 
-// Define a struct to keep track of each move's details
-struct MoveRecord {
-    int move_number;
-    std::string from;
-    std::string to;
-    int player; // 1 for white, -1 for black
-    std::chrono::steady_clock::time_point timestamp;
+// State needed to take a move back, kept on a fixed-size stack
+struct UndoInfo
+{
+    Move move;
+    int8_t captured;            // Piece removed by the move, or EMPTY
+    uint8_t castling;           // Castling rights before the move
+    int8_t en_passant;          // En passant square before the move
+    int fifty_move_counter;     // 50-move counter before the move
+    uint64_t key;               // Zobrist key before the move, also the repetition history
 };
 
+// Capacity of the undo stack: reversible game moves plus the deepest probe
+constexpr int MAX_UNDO = 1024;
+
 class Board
 {
     public:
         Board(bool enable_history = true);
         void initialize();
+        bool from_fen(const std::string& fen);                  // Sets up a position from FEN
+        std::string to_fen() const;
+        bool pack(PackedPosition& packed) const;                // 32-byte binary form, see packed.hpp
+        bool unpack(const PackedPosition& packed);              // False on a corrupt record
+        void set_position(const Position& position);            // Starts a new game at the position
         void display() const;
-        bool move_piece(const std::string& from, const std::string& to);
+        bool move_piece(const std::string& from, const std::string& to, char promotion = 'Q');
+        void make_move(Move move);                              // Plays a pseudo-legal move
+        void unmake_move();                                     // Takes back the last make_move
+        void make_null_move();                                  // Passes the turn (null-move pruning)
+        void unmake_null_move();
 		void show_history() const;
 
 		void set_history_enabled(bool enable);
 
         int get_piece(int x, int y) const;                      // Get piece at (x, y)
-        const std::vector<std::vector<int>>& get_board() const; // Get entire board
-        int get_fifty_move_counter() const { return fifty_move_counter; }
+        std::vector<std::vector<int>> get_board() const;        // Grid view of the position
+        const Position& get_position() const { return pos; }    // Bitboard position core
+        int get_turn() const { return pos.turn; }
+        int get_fifty_move_counter() const { return pos.fifty_move_counter; }
+        int get_fullmove_number() const { return move_count / 2 + 1; }
+        uint64_t get_key() const { return pos.key; }
         bool is_threefold_repetition() const;
+        bool is_repetition() const;                             // Position seen before (search draw)
         std::string board_to_string() const;
         bool is_in_check(int player) const;
         std::pair<int, int> find_king_position(int player) const;
 
     private:
-        std::vector<std::vector<int>> board;
-		std::vector<MoveRecord> history; // Stores the history of moves
-        int move_count; // Count of the total moves made
-        int turn; // 1 for white's turn, -1 for black's turn
+        Position pos;
+        std::array<UndoInfo, MAX_UNDO> undo_stack;
+        int undo_size = 0;
+		MoveHistory history;            // Game moves played through move_piece
+        int move_count; // Plies played since the start of the game
         bool enable_history;
-        int fifty_move_counter = 0; // Counter for 50-move rule
-        mutable std::unordered_map<std::string, int> position_history; 
 
         bool is_valid_move(int x1, int y1, int x2, int y2, int player) const;
 };
@@ -0,0 +1,54 @@
+// book.hpp
+#ifndef BOOK_HPP
+#define BOOK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "board.hpp"
+
+// Hash of a position as the Polyglot book format defines it
+uint64_t polyglot_key(const Position& pos);
+
+enum class BookSelection
+{
+    Weighted,   // Random, in proportion to the entry weights
+    Best        // Always the highest weight
+};
+
+// Polyglot .bin opening book. The file is memory-mapped and searched in
+// place: opening does no reading, and probes binary-search the sorted keys.
+class OpeningBook
+{
+    public:
+        OpeningBook() = default;
+        ~OpeningBook();
+        OpeningBook(const OpeningBook&) = delete;
+        OpeningBook& operator=(const OpeningBook&) = delete;
+
+        bool open(const std::string& path);
+        void close();
+        bool is_open() const { return data != nullptr; }
+        size_t size() const { return count; }
+
+        void set_selection(BookSelection mode) { selection = mode; }
+        std::vector<std::pair<Move, int>> entries(const Board& board) const;
+
+        // Book move for the position, or NULL_MOVE; random drives weighted selection
+        Move probe(const Board& board, uint64_t random) const;
+
+    private:
+        const void* data = nullptr;
+        size_t bytes = 0;
+        size_t count = 0;
+        BookSelection selection = BookSelection::Weighted;
+};
+
+extern OpeningBook BOOK;
+
+// book <file.bin> [fen]: lists the book entries of a position
+int book_command(const std::vector<std::string>& args);
+
+#endif // BOOK_HPP
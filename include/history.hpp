@@ -0,0 +1,69 @@
+// history.hpp
+#ifndef HISTORY_HPP
+#define HISTORY_HPP
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include "moves.hpp"
+
+// One played move in 8 bytes; text is only produced when the history is shown
+struct MoveRecord
+{
+    Move move;
+    int8_t piece;           // Piece that moved, its sign gives the player
+    int8_t captured;        // Piece taken, or EMPTY
+    uint32_t elapsed_us;    // Time since the previous record (or the start), saturating
+};
+
+static_assert(sizeof(MoveRecord) == 8, "MoveRecord must stay packed");
+
+// Moves kept; older ones are overwritten once a game grows past it
+constexpr int HISTORY_CAPACITY = 1024;
+
+// Game record in a fixed ring buffer: recording never allocates
+class MoveHistory
+{
+    public:
+        typedef std::chrono::steady_clock Clock;
+
+        // Starts over; first_ply numbers the first move recorded after it
+        void clear(int first_ply = 0)
+        {
+            total = 0;
+            start_ply = first_ply;
+            last = Clock::now();
+        }
+
+        void record(Move move, int piece, int captured)
+        {
+            Clock::time_point now = Clock::now();
+            auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(now - last).count();
+            last = now;
+
+            MoveRecord& entry = records[total % HISTORY_CAPACITY];
+            entry.move = move;
+            entry.piece = static_cast<int8_t>(piece);
+            entry.captured = static_cast<int8_t>(captured);
+            entry.elapsed_us = static_cast<uint32_t>(std::min<int64_t>(elapsed, UINT32_MAX));
+            ++total;
+        }
+
+        int size() const { return total < HISTORY_CAPACITY ? total : HISTORY_CAPACITY; }
+        bool empty() const { return total == 0; }
+
+        // Records from the oldest kept; ply() gives the game ply of each
+        const MoveRecord& operator[](int i) const { return records[(first() + i) % HISTORY_CAPACITY]; }
+        int ply(int i) const { return start_ply + first() + i + 1; }
+
+    private:
+        int first() const { return total - size(); }
+
+        std::array<MoveRecord, HISTORY_CAPACITY> records;
+        int total = 0;              // Moves recorded since clear()
+        int start_ply = 0;
+        Clock::time_point last = Clock::now();
+};
+
+#endif // HISTORY_HPP
@@ -0,0 +1,100 @@
+// instrument.hpp
+#ifndef INSTRUMENT_HPP
+#define INSTRUMENT_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Hot-path probes. Build with `make INSTRUMENT=1` (after `make clean`) to
+// compile them in; otherwise INSTRUMENT_SCOPE expands to nothing.
+enum class Probe
+{
+    GenerateLegalMoves,
+    IsInCheck,
+    MovePiece,
+    IsCheckmate,
+    IsStalemate,
+    Evaluate,
+    Search,
+    Count
+};
+
+// Merges every thread's counters and writes them as JSON. Timings are
+// inclusive: a probe's time contains the probes it calls.
+void instrument_dump(std::ostream& out);
+bool instrument_dump_file(const std::string& path);
+void instrument_reset();
+
+#ifdef CHESS_INSTRUMENT
+
+#include <atomic>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+inline uint64_t instrument_cycles() { return __rdtsc(); }
+#else
+#include <chrono>
+inline uint64_t instrument_cycles()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#endif
+
+constexpr int PROBE_COUNT = static_cast<int>(Probe::Count);
+constexpr int HISTOGRAM_BUCKETS = 40;   // Bucket b holds durations of [2^b, 2^(b+1)) cycles
+
+// One thread's counters. Only the owning thread writes, with plain relaxed
+// stores rather than locked increments; dumps read them from any thread.
+struct InstrumentShard
+{
+    struct Counters
+    {
+        std::atomic<uint64_t> calls{0};
+        std::atomic<uint64_t> cycles{0};
+        std::atomic<uint64_t> histogram[HISTOGRAM_BUCKETS] = {};
+    };
+    Counters probes[PROBE_COUNT];
+};
+
+InstrumentShard& instrument_shard();
+
+inline void instrument_bump(std::atomic<uint64_t>& counter, uint64_t amount)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+inline void instrument_record(Probe probe, uint64_t cycles)
+{
+    InstrumentShard::Counters& counters = instrument_shard().probes[static_cast<int>(probe)];
+    int bucket = 63 - __builtin_clzll(cycles | 1);
+    instrument_bump(counters.calls, 1);
+    instrument_bump(counters.cycles, cycles);
+    instrument_bump(counters.histogram[bucket < HISTOGRAM_BUCKETS ? bucket : HISTOGRAM_BUCKETS - 1], 1);
+}
+
+// Times the enclosing scope
+class InstrumentScope
+{
+    public:
+        explicit InstrumentScope(Probe probe) : probe(probe), start(instrument_cycles()) {}
+        ~InstrumentScope() { instrument_record(probe, instrument_cycles() - start); }
+        InstrumentScope(const InstrumentScope&) = delete;
+        InstrumentScope& operator=(const InstrumentScope&) = delete;
+
+    private:
+        Probe probe;
+        uint64_t start;
+};
+
+#define INSTRUMENT_JOIN_(a, b) a##b
+#define INSTRUMENT_JOIN(a, b) INSTRUMENT_JOIN_(a, b)
+#define INSTRUMENT_SCOPE(probe) InstrumentScope INSTRUMENT_JOIN(instrument_scope_, __LINE__)(probe)
+
+#else
+
+#define INSTRUMENT_SCOPE(probe) ((void)0)
+
+#endif // CHESS_INSTRUMENT
+
+#endif // INSTRUMENT_HPP
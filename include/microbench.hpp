@@ -0,0 +1,26 @@
+// microbench.hpp
+#ifndef MICROBENCH_HPP
+#define MICROBENCH_HPP
+
+#include <string>
+#include <vector>
+
+// Timing of one primitive, in nanoseconds per call
+struct MicrobenchResult
+{
+    std::string name;
+    size_t calls_per_sample = 0;
+    double median_ns = 0.0;
+    double p99_ns = 0.0;
+    double min_ns = 0.0;
+    double mean_ns = 0.0;
+};
+
+// Times the core primitives over a fixed corpus of positions: warmup passes
+// first, then one sample per repetition. Names containing filter only.
+std::vector<MicrobenchResult> run_microbench(int warmup, int repetitions, const std::string& filter = "");
+
+// Command line entry: bench [-w warmup] [-r repetitions] [-o file.json] [filter]
+int microbench_command(const std::vector<std::string>& args);
+
+#endif // MICROBENCH_HPP
@@ -0,0 +1,13 @@
+// movegen.hpp
+#ifndef MOVEGEN_HPP
+#define MOVEGEN_HPP
+
+#include "board.hpp"
+#include "moves.hpp"
+
+// Fills the list with the legal moves of the side to move. Checkers, pinned
+// pieces and the evasion mask are computed once, so no move needs to be
+// played and verified afterwards.
+void generate_legal_moves(const Board& board, MoveList& moves);
+
+#endif // MOVEGEN_HPP
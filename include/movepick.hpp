@@ -0,0 +1,64 @@
+// movepick.hpp
+#ifndef MOVEPICK_HPP
+#define MOVEPICK_HPP
+
+#include "board.hpp"
+#include "moves.hpp"
+#include "search.hpp"
+
+constexpr int MAX_HISTORY = 16384;
+
+// Quiet move statistics gathered by one search thread
+struct HistoryTables
+{
+    Move killers[MAX_PLY + 1][2];   // Quiet moves that caused a cutoff at each ply
+    int butterfly[2][64][64];       // By color, from and to square
+    Move countermoves[12][64];      // Best reply to a piece arriving on a square
+
+    void clear();
+
+    // Rewards a quiet move that failed high and penalizes the quiets tried before it.
+    // previous is the move that led to this node, or NULL_MOVE at the root.
+    void update(const Position& pos, Move best, const Move* tried, int tried_count, int depth, int ply, Move previous);
+};
+
+// Hands out the legal moves in stages: transposition table move, captures
+// and promotions by MVV-LVA, killers and the countermove, the other quiets
+// by history, and last the captures that lose material by SEE. A stage is
+// scored only once reached, and moves are sorted lazily by picking the best
+// remaining one each time. With tactical_only, only the captures and
+// promotions that do not lose material come out (quiescence search).
+class MovePicker
+{
+    public:
+        MovePicker(const Board& board, const HistoryTables& history, Move tt_move, int ply, Move previous,
+                   bool tactical_only = false);
+
+        Move next();                                    // NULL_MOVE when exhausted
+        int legal_count() const { return moves.size(); }
+
+    private:
+        enum Stage { TT_MOVE, INIT_CAPTURES, CAPTURES, SPECIAL_QUIETS, INIT_QUIETS, QUIETS, BAD_CAPTURES, DONE };
+
+        const Position& pos;
+        const HistoryTables& history;
+        MoveList moves;
+        int scores[MAX_MOVES];
+        Move tt_move;
+        Move special[3];                                // Killers and countermove
+        int special_index = 0;
+        Move bad_captures[MAX_MOVES];
+        int bad_count = 0;
+        int bad_index = 0;
+        bool tactical_only;
+        int capture_end = 0;
+        int current = 0;
+        int end = 0;
+        Stage stage = TT_MOVE;
+
+        Move pick_best();
+        bool is_special(Move move) const;
+        bool is_quiet_in_list(Move move) const;
+};
+
+#endif // MOVEPICK_HPP
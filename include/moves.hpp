@@ -6,27 +6,109 @@
 #include <utility>
 #include <cmath>
 #include <string>
+#include <cstdint>
 #include "piece.hpp"
+#include "position.hpp"
 
-// Getting pieces moves functions
-std::vector<std::pair<int, int>> get_pawn_moves(int x, int y,
-	const std::vector<std::vector<int>>& board, bool is_white);
-std::vector<std::pair<int, int>> get_knight_moves(int x, int y,
-	const std::vector<std::vector<int>>& board);
-std::vector<std::pair<int, int>> get_bishop_moves(int x, int y,
-	const std::vector<std::vector<int>>& board);
-std::vector<std::pair<int, int>> get_rook_moves(int x, int y,
-	const std::vector<std::vector<int>>& board);
-std::vector<std::pair<int, int>> get_queen_moves(int x, int y,
-	const std::vector<std::vector<int>>& board);
-std::vector<std::pair<int, int>> get_king_moves(int x, int y,
-	const std::vector<std::vector<int>>& board);
+// Move flags stored in the top four bits of a Move
+constexpr int MOVE_QUIET = 0;
+constexpr int MOVE_DOUBLE_PUSH = 1;
+constexpr int MOVE_KING_CASTLE = 2;
+constexpr int MOVE_QUEEN_CASTLE = 3;
+constexpr int MOVE_CAPTURE = 4;
+constexpr int MOVE_EN_PASSANT = 5;
+constexpr int MOVE_PROMOTION = 8;   // + (piece type - 2), | MOVE_CAPTURE when capturing
+
+// Compact 16-bit move: 6 bits from-square, 6 bits to-square, 4 bits flags
+struct Move
+{
+    uint16_t data;
+
+    Move() = default;
+    constexpr Move(int from, int to, int flags = MOVE_QUIET)
+        : data(static_cast<uint16_t>(from | (to << 6) | (flags << 12))) {}
+
+    constexpr int from() const { return data & 63; }
+    constexpr int to() const { return (data >> 6) & 63; }
+    constexpr int flags() const { return data >> 12; }
+    constexpr bool is_capture() const { return flags() & MOVE_CAPTURE; }
+    constexpr bool is_promotion() const { return flags() & MOVE_PROMOTION; }
+    constexpr int promotion_type() const { return (flags() & 3) + KNIGHT_WHITE; }
+    constexpr bool is_castle() const { return flags() == MOVE_KING_CASTLE || flags() == MOVE_QUEEN_CASTLE; }
+
+    constexpr bool operator==(Move other) const { return data == other.data; }
+    constexpr bool operator!=(Move other) const { return data != other.data; }
+};
+
+constexpr Move NULL_MOVE = Move(0, 0);
+
+// Fixed-capacity move buffer owned by the caller, normally on the stack.
+// 256 is above the largest number of moves any legal position allows.
+constexpr int MAX_MOVES = 256;
+
+struct MoveList
+{
+    Move moves[MAX_MOVES];
+    int count = 0;
+
+    void add(Move move) { moves[count++] = move; }
+    void clear() { count = 0; }
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+    Move operator[](int i) const { return moves[i]; }
+    Move* begin() { return moves; }
+    Move* end() { return moves + count; }
+    const Move* begin() const { return moves; }
+    const Move* end() const { return moves + count; }
+
+    bool contains(Move move) const
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            if (moves[i] == move)
+                return true;
+        }
+        return false;
+    }
+};
+
+// Builds the encoded move for a from/to pair on the position
+Move encode_move(const Position& pos, int from, int to, int promotion_type = QUEEN_WHITE);
+std::string move_to_string(Move move);
+
+// Getting pieces moves functions: each appends pseudo-legal moves to the list
+void get_pawn_moves(int x, int y, const Position& pos, bool is_white, MoveList& moves);
+void get_knight_moves(int x, int y, const Position& pos, MoveList& moves);
+void get_bishop_moves(int x, int y, const Position& pos, MoveList& moves);
+void get_rook_moves(int x, int y, const Position& pos, MoveList& moves);
+void get_queen_moves(int x, int y, const Position& pos, MoveList& moves);
+void get_king_moves(int x, int y, const Position& pos, MoveList& moves);
+
+// Attack helpers
+bool is_square_attacked(const Position& pos, int square, int by_player);
+Bitboard attackers_to(const Position& pos, int square, Bitboard occupied);
+bool castling_allowed(const Position& pos, int player, bool is_kingside);
+
+// Side-specialized forms (Us is WHITE or BLACK), instantiated in moves.cpp.
+// attacked_by sees sliders through the given occupancy.
+template<int Us> bool attacked_by(const Position& pos, int square, Bitboard occupied);
+template<int Us, bool Kingside> bool castling_allowed(const Position& pos);
+
+// Material values used by exchange evaluation, by piece type
+constexpr int SEE_VALUES[7] = {0, 100, 320, 330, 500, 900, 20000};
+
+// Static exchange evaluation: material the side to move wins or loses on the
+// destination square if both sides keep capturing there with their cheapest piece
+int see(const Position& pos, Move move);
 
 //Utils
 std::string index_to_chess(int row, int col);
 std::pair<int, int> chess_to_index(const std::string& position);
 
 // General piece moves function
-std::vector<std::pair<int, int>> get_moves(int x, int y, const std::vector<std::vector<int>>& board);
+void get_moves(int x, int y, const Position& pos, MoveList& moves);
+
+// Pseudo-legal moves of every piece of the side to move
+void generate_moves(const Position& pos, MoveList& moves);
 
-#endif // MOVES_HPP
\ No newline at end of file
+#endif // MOVES_HPP
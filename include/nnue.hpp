@@ -0,0 +1,77 @@
+// nnue.hpp
+#ifndef NNUE_HPP
+#define NNUE_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "position.hpp"
+#include "moves.hpp"
+
+// Small quantized network: 768 piece-square inputs per perspective feed a
+// 256-wide int16 accumulator, followed by 512 -> 32 -> 32 -> 1 int8 layers
+constexpr int NNUE_INPUTS = 768;
+constexpr int NNUE_HIDDEN = 256;
+constexpr int NNUE_L2 = 32;
+constexpr int NNUE_L3 = 32;
+
+// First-layer sums for both perspectives (white, black)
+struct alignas(64) NNUEAccumulator
+{
+    int16_t values[2][NNUE_HIDDEN];
+};
+
+// Loads weights in the layout documented in nnue.cpp; false on a bad file
+bool nnue_load(const std::string& path);
+bool nnue_save(const std::string& path);
+// Untrained network from a seed, for measuring speed without a weights file
+void nnue_init_random(uint32_t seed);
+
+bool nnue_loaded();
+void nnue_set_enabled(bool enable);
+bool nnue_enabled();                    // Loaded and switched on
+const char* nnue_kernel_name();         // SIMD kernels picked at startup
+
+void nnue_refresh(const Position& pos, NNUEAccumulator& accumulator);
+int nnue_evaluate(const Position& pos, const NNUEAccumulator& accumulator);
+int nnue_evaluate(const Position& pos); // Full refresh, side to move's point of view
+
+// One accumulator per ply. push() records which pieces a move changes and
+// the accumulator is only brought up to date when a position is evaluated.
+class NNUEStack
+{
+    public:
+        NNUEStack() : entries(MAX_DEPTH) {}
+
+        void reset(const Position& pos);
+        void push(const Position& before, Move move);
+        void push_null();
+        void pop() { --top; }
+        int evaluate(const Position& pos);
+
+    private:
+        static constexpr int MAX_DEPTH = 256;
+
+        struct DirtyPiece
+        {
+            int piece;
+            int from;           // NO_SQUARE when the piece is added
+            int to;             // NO_SQUARE when the piece is removed
+        };
+
+        struct Entry
+        {
+            NNUEAccumulator accumulator;
+            DirtyPiece dirty[3];
+            int dirty_count = 0;
+            bool computed = false;
+        };
+
+        std::vector<Entry> entries;
+        int top = 0;
+};
+
+// Command line entry: nnuebench [weights file], classical vs neural speed
+int nnue_bench_command(const std::vector<std::string>& args);
+
+#endif // NNUE_HPP
@@ -0,0 +1,40 @@
+// packed.hpp
+#ifndef PACKED_HPP
+#define PACKED_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include "position.hpp"
+
+// Fixed 32-byte position record for bulk storage: the occupancy bitboard,
+// then one nibble (piece_index) per occupied square in square order, then
+// the side to move, castling rights, en passant square and both counters.
+// Records can be written and read as raw bytes on little-endian machines.
+struct PackedPosition
+{
+    uint64_t occupied;
+    uint8_t pieces[16];         // Low nibble first; at most 32 pieces
+    uint8_t flags;              // Bit 0 black to move, bits 1-4 castling rights
+    int8_t en_passant;          // Square or NO_SQUARE
+    uint8_t halfmove;           // Fifty-move counter, capped at 255
+    uint8_t reserved;
+    uint16_t fullmove;
+    uint16_t reserved2;
+};
+
+static_assert(sizeof(PackedPosition) == 32, "PackedPosition must stay 32 bytes");
+
+// Fails on positions with more than 32 pieces, which the record cannot hold
+bool pack_position(const Position& pos, int fullmove, PackedPosition& packed);
+
+// Rebuilds the position, key and evaluation totals and the fullmove number.
+// Records are checked before use (at most 32 pieces, piece codes below 12,
+// no pawn on a back rank, en passant on the board); a corrupt one fails and
+// leaves pos cleared. Castling rights the placement rules out are dropped.
+bool unpack_position(const PackedPosition& packed, Position& pos, int& fullmove);
+
+// Decodes a whole array, e.g. a file read or mapped in one piece; returns
+// the number of valid records, the invalid ones are left cleared
+size_t unpack_positions(const PackedPosition* packed, Position* positions, size_t count);
+
+#endif // PACKED_HPP
@@ -0,0 +1,28 @@
+// perft.hpp
+#ifndef PERFT_HPP
+#define PERFT_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <utility>
+#include "board.hpp"
+
+// Result of a perft run, with the per-move breakdown when divide is requested
+struct PerftResult
+{
+    uint64_t nodes = 0;
+    double seconds = 0.0;
+    std::vector<std::pair<Move, uint64_t>> divide;
+};
+
+// Counts the leaf nodes of the legal move tree to the given depth
+uint64_t perft(Board& board, int depth);
+
+// Runs perft from the board, splitting the root moves over worker threads
+PerftResult run_perft(const Board& board, int depth, int threads, bool divide = false);
+
+// Command line entry: perft [depth] [fen], divide <depth> [fen], perft suite [depth]
+int perft_command(const std::vector<std::string>& args);
+
+#endif // PERFT_HPP
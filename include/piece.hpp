@@ -16,4 +16,17 @@ constexpr int ROOK_BLACK = -4;
 constexpr int QUEEN_BLACK = -5;
 constexpr int KING_BLACK = -6;
 
+// Colors used to index per-side tables (players are still 1 / -1)
+constexpr int WHITE = 0;
+constexpr int BLACK = 1;
+
+constexpr int color_index(int player) { return player > 0 ? WHITE : BLACK; }
+
+// Piece type without color (1 = pawn ... 6 = king)
+constexpr int piece_type(int piece) { return piece < 0 ? -piece : piece; }
+
+// Maps a piece (-6..6, not EMPTY) to a bitboard slot 0..11 and back
+constexpr int piece_index(int piece) { return piece > 0 ? piece - 1 : 5 - piece; }
+constexpr int index_piece(int index) { return index < 6 ? index + 1 : 5 - index; }
+
 #endif // PIECE_HPP
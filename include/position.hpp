@@ -0,0 +1,165 @@
+// position.hpp
+#ifndef POSITION_HPP
+#define POSITION_HPP
+
+#include <cstdint>
+#include <type_traits>
+#include "bitboard.hpp"
+#include "piece.hpp"
+#include "zobrist.hpp"
+#include "psqt.hpp"
+
+// Castling rights bits
+constexpr int WHITE_OO = 1;
+constexpr int WHITE_OOO = 2;
+constexpr int BLACK_OO = 4;
+constexpr int BLACK_OOO = 8;
+constexpr int ALL_CASTLING = WHITE_OO | WHITE_OOO | BLACK_OO | BLACK_OOO;
+
+// Everything that depends on the side, fixed at compile time. Generators and
+// attack checks are templated on Us (WHITE or BLACK) and dispatch on the
+// player once at their entry point.
+template<int Us>
+struct Side
+{
+    static_assert(Us == WHITE || Us == BLACK, "Us is a color index");
+
+    static constexpr int them = Us ^ 1;
+    static constexpr int player = Us == WHITE ? 1 : -1;     // Sign of the side's pieces
+
+    static constexpr int pawn = PAWN_WHITE * player;
+    static constexpr int knight = KNIGHT_WHITE * player;
+    static constexpr int bishop = BISHOP_WHITE * player;
+    static constexpr int rook = ROOK_WHITE * player;
+    static constexpr int queen = QUEEN_WHITE * player;
+    static constexpr int king = KING_WHITE * player;
+
+    static constexpr int push = 8 * player;                 // Square delta of a pawn step
+    static constexpr int start_rank = Us == WHITE ? 1 : 6;
+    static constexpr Bitboard promotion_rank = Us == WHITE ? RANK_8 : RANK_1;
+
+    static constexpr int king_start = Us == WHITE ? 4 : 60;
+    static constexpr int castle_kingside = Us == WHITE ? WHITE_OO : BLACK_OO;
+    static constexpr int castle_queenside = Us == WHITE ? WHITE_OOO : BLACK_OOO;
+};
+
+// Plain-data position core: cheap to copy and scan
+struct Position
+{
+    Bitboard pieces[12];        // One bitboard per piece, indexed by piece_index()
+    Bitboard occupancy[2];      // All pieces of each color
+    Bitboard occupied;          // Both colors
+    int8_t squares[64];         // Mailbox mirror of the bitboards for O(1) lookups
+    int8_t turn;                // 1 for white's turn, -1 for black's turn
+    uint8_t castling;           // Castling rights bits
+    int8_t en_passant;          // Square a pawn may capture on, or NO_SQUARE
+    int fifty_move_counter;     // Counter for 50-move rule
+    uint64_t key;               // Zobrist hash, updated incrementally
+    int mg_score;               // Material + piece-square totals (white - black), middlegame
+    int eg_score;               // Same for the endgame
+    int phase;                  // Sum of PHASE_WEIGHTS of the pieces on the board
+
+    void clear()
+    {
+        *this = Position{};
+        turn = 1;
+        en_passant = NO_SQUARE;
+        key = compute_key();
+    }
+
+    int piece_on(int square) const { return squares[square]; }
+    Bitboard pieces_of(int piece) const { return pieces[piece_index(piece)]; }
+    Bitboard color_pieces(int player) const { return occupancy[color_index(player)]; }
+
+    int king_square(int player) const
+    {
+        Bitboard king = pieces_of(player == 1 ? KING_WHITE : KING_BLACK);
+        return king ? lsb(king) : NO_SQUARE;
+    }
+
+    // Castling rights the placement allows: king and rook still on their home squares
+    int castling_possible() const
+    {
+        int rights = 0;
+        if (squares[4] == KING_WHITE)
+            rights |= (squares[7] == ROOK_WHITE ? WHITE_OO : 0) | (squares[0] == ROOK_WHITE ? WHITE_OOO : 0);
+        if (squares[60] == KING_BLACK)
+            rights |= (squares[63] == ROOK_BLACK ? BLACK_OO : 0) | (squares[56] == ROOK_BLACK ? BLACK_OOO : 0);
+        return rights;
+    }
+
+    // Pawns never stand on the first or last rank
+    bool pawns_on_back_ranks() const
+    {
+        return ((pieces_of(PAWN_WHITE) | pieces_of(PAWN_BLACK)) & (RANK_1 | RANK_8)) != 0;
+    }
+
+    // Knights, bishops, rooks or queens; without them zugzwang is likely
+    bool has_non_pawn_material(int player) const
+    {
+        int sign = player > 0 ? 1 : -1;
+        return (pieces_of(KNIGHT_WHITE * sign) | pieces_of(BISHOP_WHITE * sign) |
+                pieces_of(ROOK_WHITE * sign) | pieces_of(QUEEN_WHITE * sign)) != 0;
+    }
+
+    void add_piece(int piece, int square)
+    {
+        Bitboard bb = square_bb(square);
+        pieces[piece_index(piece)] |= bb;
+        occupancy[color_index(piece)] |= bb;
+        occupied |= bb;
+        squares[square] = static_cast<int8_t>(piece);
+        key ^= ZOBRIST.piece[piece_index(piece)][square];
+        mg_score += PSQT.mg[piece_index(piece)][square];
+        eg_score += PSQT.eg[piece_index(piece)][square];
+        phase += PHASE_WEIGHTS[piece_type(piece)];
+    }
+
+    void remove_piece(int square)
+    {
+        int piece = squares[square];
+        Bitboard bb = square_bb(square);
+        pieces[piece_index(piece)] ^= bb;
+        occupancy[color_index(piece)] ^= bb;
+        occupied ^= bb;
+        squares[square] = EMPTY;
+        key ^= ZOBRIST.piece[piece_index(piece)][square];
+        mg_score -= PSQT.mg[piece_index(piece)][square];
+        eg_score -= PSQT.eg[piece_index(piece)][square];
+        phase -= PHASE_WEIGHTS[piece_type(piece)];
+    }
+
+    void relocate_piece(int from, int to)
+    {
+        int piece = squares[from];
+        Bitboard bb = square_bb(from) | square_bb(to);
+        pieces[piece_index(piece)] ^= bb;
+        occupancy[color_index(piece)] ^= bb;
+        occupied ^= bb;
+        squares[from] = EMPTY;
+        squares[to] = static_cast<int8_t>(piece);
+        key ^= ZOBRIST.piece[piece_index(piece)][from] ^ ZOBRIST.piece[piece_index(piece)][to];
+        mg_score += PSQT.mg[piece_index(piece)][to] - PSQT.mg[piece_index(piece)][from];
+        eg_score += PSQT.eg[piece_index(piece)][to] - PSQT.eg[piece_index(piece)][from];
+    }
+
+    // Hash of the whole position from scratch; make_move keeps key equal to it
+    uint64_t compute_key() const
+    {
+        uint64_t hash = ZOBRIST.castling[castling];
+        for (int square = 0; square < 64; ++square)
+        {
+            if (squares[square] != EMPTY)
+                hash ^= ZOBRIST.piece[piece_index(squares[square])][square];
+        }
+        if (en_passant != NO_SQUARE)
+            hash ^= ZOBRIST.en_passant[square_col(en_passant)];
+        if (turn == -1)
+            hash ^= ZOBRIST.side;
+        return hash;
+    }
+};
+
+static_assert(std::is_trivially_copyable<Position>::value, "Position must stay plain data");
+
+#endif // POSITION_HPP
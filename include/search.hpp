@@ -0,0 +1,94 @@
+// search.hpp
+#ifndef SEARCH_HPP
+#define SEARCH_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "board.hpp"
+
+constexpr int MAX_PLY = 64;
+constexpr int INFINITE_SCORE = 32001;
+constexpr int MATE_SCORE = 32000;
+constexpr int MATE_BOUND = MATE_SCORE - MAX_PLY; // Scores beyond this are mates
+
+// Tablebase results score between TB_BOUND and MATE_BOUND (see tablebase_score):
+// 254 plies is more than any table value encodes
+constexpr int TB_MAX_DTM = 254;
+constexpr int TB_BOUND = MATE_BOUND - 1 - MAX_PLY - TB_MAX_DTM;
+
+struct SearchStats
+{
+    uint64_t nodes = 0;
+    uint64_t nps = 0;
+    double seconds = 0.0;
+    int depth = 0;              // Last fully searched depth
+    uint64_t tt_probes = 0;
+    uint64_t tt_hits = 0;
+    uint64_t tt_stores = 0;
+    uint64_t tt_collisions = 0; // Stores that evicted another position of the same search
+    int hashfull = 0;           // Per mille of the table in use
+    uint64_t beta_cutoffs = 0;
+    uint64_t first_move_cutoffs = 0;    // Cutoffs by the first move searched, a move ordering measure
+    double branching_factor = 0.0;      // Main thread nodes of the last iteration over the one before
+    uint64_t tb_hits = 0;               // Nodes scored by the endgame tablebases
+
+    double first_move_cutoff_rate() const
+    {
+        return beta_cutoffs ? static_cast<double>(first_move_cutoffs) / beta_cutoffs : 0.0;
+    }
+};
+
+struct SearchResult
+{
+    Move best_move = NULL_MOVE;
+    int score = 0;              // Centipawns from the side to move's point of view
+    std::vector<Move> pv;       // Principal variation, starting with best_move
+    SearchStats stats;
+};
+
+// Selective search techniques, each switchable for A/B comparisons
+struct SearchFeatures
+{
+    bool null_move = true;          // Null-move pruning
+    bool late_move_reductions = true;
+    bool reverse_futility = true;   // Static eval far above beta cuts shallow nodes
+    bool futility = true;           // Quiet moves that cannot raise alpha near the leaves
+    bool aspiration = true;         // Narrow root window around the previous score
+};
+
+// Budget for one search; zero means no limit of that kind
+struct SearchLimits
+{
+    int depth = MAX_PLY - 1;
+    int64_t time_ms = 0;                        // Hard limit
+    int64_t soft_time_ms = 0;                   // No new iteration past this; 0 means time_ms / 2
+    uint64_t nodes = 0;                         // Counted on the main thread
+    int threads = 1;                            // Lazy SMP: the main thread plus helpers
+    const std::atomic<bool>* stop = nullptr;    // Optional external stop request
+    const std::atomic<bool>* ponder = nullptr;  // Time limits wait while this is set
+    SearchFeatures features;
+
+    // Called by the main thread after each completed iteration
+    std::function<void(const SearchResult&)> on_iteration;
+};
+
+class TranspositionTable;
+
+// Negamax alpha-beta with iterative deepening from the board's position.
+// With several threads, helpers search copies of the board and share the
+// transposition table; the deepest completed result wins. The first form
+// uses the global TT, the second a table of the caller's own.
+SearchResult search(Board& board, const SearchLimits& limits);
+SearchResult search(Board& board, const SearchLimits& limits, TranspositionTable& tt);
+
+// Command line entry: featurebench [ms per position], depth reached with each
+// selective technique switched off in turn
+int feature_bench_command(const std::vector<std::string>& args);
+
+// Command line entry: smpbench [depth] [max threads], time-to-depth from 1 to N threads
+int smp_bench_command(const std::vector<std::string>& args);
+
+#endif // SEARCH_HPP
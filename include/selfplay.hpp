@@ -0,0 +1,48 @@
+// selfplay.hpp
+#ifndef SELFPLAY_HPP
+#define SELFPLAY_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "board.hpp"
+#include "search.hpp"
+#include "tt.hpp"
+
+// How moves are chosen during self-play
+enum class SelfPlayPolicy
+{
+    Engine,     // Search with the configured limits after a few random opening plies
+    Random      // Uniformly random legal moves
+};
+
+struct SelfPlayConfig
+{
+    int games = 1000;
+    int threads = 1;
+    uint64_t seed = 1;
+    SelfPlayPolicy policy = SelfPlayPolicy::Engine;
+    SearchLimits limits;            // Engine policy budget; keep it fixed-depth or fixed-node to stay reproducible
+    int random_opening_plies = 8;   // Engine policy only, so games differ
+    int max_plies = 400;            // Adjudicated as a draw beyond this
+    std::string log_path;           // One line per game, empty for none
+};
+
+// Outcome of one game
+struct GameRecord
+{
+    int index = 0;
+    int result = 0;                 // 1 white wins, -1 black wins, 0 draw
+    int plies = 0;
+    const char* reason = "";        // checkmate, stalemate, fifty-move, repetition, material, tablebase, max-plies
+};
+
+// Plays one game from the start position with a PRNG seeded from the game index.
+// Searches use tt, cleared first, so the game depends only on the config and index.
+GameRecord play_selfplay_game(const SelfPlayConfig& config, int index, TranspositionTable& tt);
+
+// Games reaching a position the loaded tablebases cover end there with its exact result.
+// Command line entry: selfplay [games] [-t threads] [-p engine|random] [-d depth] [-n nodes] [-s seed] [-o log] [-e tbdir]
+int selfplay_command(const std::vector<std::string>& args);
+
+#endif // SELFPLAY_HPP
@@ -0,0 +1,72 @@
+// tablebase.hpp
+#ifndef TABLEBASE_HPP
+#define TABLEBASE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "board.hpp"
+
+// Endgames with up to this many pieces, kings included, have tables
+constexpr int TB_MAX_PIECES = 4;
+
+// Exact outcome for the side to move
+struct TBResult
+{
+    int wdl = 0;    // 1 win, 0 draw, -1 loss
+    int dtm = 0;    // Plies to mate with best play from both sides, 0 for draws
+};
+
+// Distance-to-mate tables written by tbgen, one file per material signature
+// (e.g. KRvKN.ctb). Files hold one byte per position and are memory-mapped,
+// so a probe is an index computation and a load.
+class Tablebases
+{
+    public:
+        Tablebases() = default;
+        ~Tablebases();
+        Tablebases(const Tablebases&) = delete;
+        Tablebases& operator=(const Tablebases&) = delete;
+
+        int load(const std::string& directory);     // Maps every table in it, returns how many
+        bool map_table(const std::string& path);
+        void close();
+        bool empty() const { return tables.empty(); }
+        bool contains(const std::string& name) const;
+        int max_dtm() const;                        // Longest mate over the mapped tables, in plies
+
+        // False when the position is not covered: too many pieces, castling
+        // rights, an en passant square or a table that is not loaded
+        bool probe(const Position& pos, TBResult& result) const;
+
+    private:
+        struct Table
+        {
+            std::string name;
+            const uint8_t* values = nullptr;
+            uint64_t entries = 0;
+            int max_dtm = 0;
+            void* mapping = nullptr;
+            size_t bytes = 0;
+        };
+        std::vector<Table> tables;
+        std::vector<int> by_material;   // Slot in tables by material code, -1 when missing
+};
+
+extern Tablebases TABLEBASES;
+
+// Move the tables prefer: the quickest win, else a draw, else the longest
+// defence. NULL_MOVE when the position or one of its successors is not covered.
+Move tablebase_move(Board& board, TBResult& result);
+
+// Search score of a table result found ply plies from the root
+int tablebase_score(const TBResult& result, int ply);
+
+// tbgen <dir> [-t threads] [tables...]: retrograde generation of the 3 and 4 piece tables
+int tbgen_command(const std::vector<std::string>& args);
+
+// tbprobe <dir> [fen]: table values of a position and of its moves
+int tbprobe_command(const std::vector<std::string>& args);
+
+#endif // TABLEBASE_HPP
@@ -0,0 +1,75 @@
+// tt.hpp
+#ifndef TT_HPP
+#define TT_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "moves.hpp"
+
+// How a stored score relates to the true value of the position
+constexpr int BOUND_NONE = 0;
+constexpr int BOUND_UPPER = 1;  // Failed low: true score <= stored score
+constexpr int BOUND_LOWER = 2;  // Failed high: true score >= stored score
+constexpr int BOUND_EXACT = 3;
+
+constexpr size_t DEFAULT_HASH_MB = 16;
+
+// Decoded contents of an entry
+struct TTData
+{
+    Move move;
+    int score;
+    int eval;
+    int depth;
+    int bound;
+};
+
+// One slot: the key is stored XORed with the data word, so a torn write
+// from another thread fails verification instead of returning wrong data
+struct TTEntry
+{
+    std::atomic<uint64_t> key_xor_data;
+    std::atomic<uint64_t> data;
+};
+
+// Four entries fill exactly one cache line
+struct alignas(64) TTBucket
+{
+    TTEntry entries[4];
+};
+
+// Fixed-size hash table shared by all search threads without locks
+class TranspositionTable
+{
+    public:
+        void resize(size_t megabytes);
+        void clear();
+        void new_search();                 // Ages the entries of earlier searches
+
+        bool probe(uint64_t key, TTData& data) const;
+
+        // Returns true when the store evicted a different position of this search
+        bool store(uint64_t key, Move move, int score, int eval, int depth, int bound);
+
+        int hashfull() const;              // Per mille of sampled slots used by this search
+        size_t size_mb() const { return bucket_count * sizeof(TTBucket) >> 20; }
+        bool empty() const { return bucket_count == 0; }
+
+    private:
+        std::unique_ptr<TTBucket[]> buckets;
+        size_t bucket_count = 0;
+        std::atomic<uint8_t> generation{0}; // 6-bit search age; independent searches may run at once
+
+        TTBucket& bucket_for(uint64_t key) const
+        {
+            // Maps the key onto the table without needing a power-of-two size
+            return buckets[static_cast<size_t>((static_cast<unsigned __int128>(key) * bucket_count) >> 64)];
+        }
+};
+
+// Table shared by every search in the process
+extern TranspositionTable TT;
+
+#endif // TT_HPP
@@ -0,0 +1,16 @@
+// uci.hpp
+#ifndef UCI_HPP
+#define UCI_HPP
+
+#include <cstdint>
+
+// Time for one move from the clock state: a share of the remaining time plus
+// most of the increment. Returns the hard limit; soft_ms receives the point
+// after which no new iteration should start.
+int64_t allocate_time(int64_t time_left, int64_t increment, int moves_to_go, int64_t& soft_ms);
+
+// Reads UCI commands from stdin until "quit". The search runs on its own
+// thread so stop, ponderhit and isready are answered while it thinks.
+int uci_loop();
+
+#endif // UCI_HPP
@@ -13,10 +13,11 @@ bool can_castle(const Board& board, int player, bool is_kingside);
 // Handles pawn promotion
 bool is_promotion(const Board& board, int x, int y);
 
-// Checks if the current player is in checkmate
+// Checks if the current player is in checkmate. Only the side to move can
+// be mated, so a player other than board.get_turn() gives false.
 bool is_checkmate(const Board& board, int player);
 
-// Checks if the current player is in stalemate
+// Checks if the current player is in stalemate (false for the side not to move)
 bool is_stalemate(const Board& board, int player);
 
 // Checks if the current player is in stalemate
@@ -0,0 +1,42 @@
+// zobrist.hpp
+#ifndef ZOBRIST_HPP
+#define ZOBRIST_HPP
+
+#include <cstdint>
+
+// Random keys XORed together to hash a position
+struct ZobristKeys
+{
+    uint64_t piece[12][64];     // Indexed by piece_index() and square
+    uint64_t castling[16];      // Indexed by the castling rights bits
+    uint64_t en_passant[8];     // Indexed by the file of the en passant square
+    uint64_t side;              // Toggled when black is to move
+};
+
+// Fixed-seed xorshift64* generator, so keys are identical on every run
+constexpr ZobristKeys generate_zobrist_keys()
+{
+    ZobristKeys keys{};
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+    auto next = [&state]()
+    {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545F4914F6CDD1DULL;
+    };
+
+    for (auto& piece : keys.piece)
+        for (auto& square : piece)
+            square = next();
+    for (auto& rights : keys.castling)
+        rights = next();
+    for (auto& file : keys.en_passant)
+        file = next();
+    keys.side = next();
+    return keys;
+}
+
+inline constexpr ZobristKeys ZOBRIST = generate_zobrist_keys();
+
+#endif // ZOBRIST_HPP
@@ -1,21 +1,59 @@
 // ai.cpp
 #include "ai.hpp"
+#include <random>
+#include "book.hpp"
+#include "instrument.hpp"
+#include "nnue.hpp"
+#include "tablebase.hpp"
 
+// Tapered material and piece-square evaluation. The middlegame and endgame
+// totals and the phase are kept up to date by the Position piece helpers,
+// so this only blends two numbers
+int evaluate_classical(const Position& pos, int player)
+{
+    int phase = std::min(pos.phase, MAX_PHASE); // Early promotions can exceed the start total
+    int score = (pos.mg_score * phase + pos.eg_score * (MAX_PHASE - phase)) / MAX_PHASE;
+    return player == 1 ? score : -score;
+}
 
-// Placeholder evaluation function
 int evaluate_board(const Board& board, int player)
 {
-    // Basic material evaluation; more factors can be added later
-    int score = 0;
-    // Calculate score based on pieces
-    // Example: For each piece, add/subtract points based on type and player
-    return score;
+    INSTRUMENT_SCOPE(Probe::Evaluate);
+    const Position& pos = board.get_position();
+    if (!nnue_enabled())
+        return evaluate_classical(pos, player);
+    int score = nnue_evaluate(pos);
+    return player == pos.turn ? score : -score;
 }
 
-std::pair<int, int> select_best_move(Board& board, int player)
+// Plays from the opening book while it has the position and from the
+// endgame tablebases once they cover it; searches otherwise
+SearchResult select_best_move(Board& board, const SearchLimits& limits)
 {
-    // Generate all possible moves for the player
-    // Evaluate each move and choose the best one
-    // For now, it returns a dummy move (needs implementation)
-    return std::make_pair(0, 0);
+    if (BOOK.is_open())
+    {
+        static thread_local std::mt19937_64 generator(std::random_device{}());
+        Move book_move = BOOK.probe(board, generator());
+        if (book_move != NULL_MOVE)
+        {
+            SearchResult result;
+            result.best_move = book_move;
+            result.pv.push_back(book_move);
+            return result;
+        }
+    }
+    if (!TABLEBASES.empty())
+    {
+        TBResult outcome;
+        Move table_move = tablebase_move(board, outcome);
+        if (table_move != NULL_MOVE)
+        {
+            SearchResult result;
+            result.best_move = table_move;
+            result.score = tablebase_score(outcome, 0);
+            result.pv.push_back(table_move);
+            return result;
+        }
+    }
+    return search(board, limits);
 }
@@ -0,0 +1,202 @@
+// bitboard.cpp
+#include "bitboard.hpp"
+#include "piece.hpp"
+
+namespace
+{
+    constexpr int KNIGHT_OFFSETS[8][2] =
+        { {2, 1}, {2, -1}, {-2, 1}, {-2, -1}, {1, 2}, {1, -2}, {-1, 2}, {-1, -2} };
+    constexpr int KING_OFFSETS[8][2] =
+        { {1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {-1, -1}, {1, -1}, {-1, 1} };
+    constexpr int WHITE_PAWN_OFFSETS[2][2] = { {1, -1}, {1, 1} };
+    constexpr int BLACK_PAWN_OFFSETS[2][2] = { {-1, -1}, {-1, 1} };
+    constexpr int BISHOP_DIRECTIONS[4][2] = { {1, 1}, {1, -1}, {-1, 1}, {-1, -1} };
+    constexpr int ROOK_DIRECTIONS[4][2] = { {1, 0}, {-1, 0}, {0, 1}, {0, -1} };
+
+    constexpr bool on_board(int rank, int file)
+    {
+        return rank >= 0 && rank < 8 && file >= 0 && file < 8;
+    }
+
+    // Offsets are (rank, file) deltas
+    constexpr Bitboard offset_mask(int square, const int offsets[][2], int count)
+    {
+        Bitboard mask = 0;
+        for (int i = 0; i < count; ++i)
+        {
+            int rank = square_rank(square) + offsets[i][0];
+            int file = square_col(square) + offsets[i][1];
+            if (on_board(rank, file))
+                mask |= square_bb(rank * 8 + file);
+        }
+        return mask;
+    }
+
+    // Walks each ray until it leaves the board or hits a blocker (included)
+    constexpr Bitboard ray_attacks(int square, Bitboard occupied, const int directions[][2])
+    {
+        Bitboard attacks = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            int rank = square_rank(square) + directions[i][0];
+            int file = square_col(square) + directions[i][1];
+            while (on_board(rank, file))
+            {
+                Bitboard bb = square_bb(rank * 8 + file);
+                attacks |= bb;
+                if (occupied & bb)
+                    break;
+                rank += directions[i][0];
+                file += directions[i][1];
+            }
+        }
+        return attacks;
+    }
+
+    constexpr StepTables make_step_tables()
+    {
+        StepTables tables{};
+        for (int square = 0; square < 64; ++square)
+        {
+            tables.knight[square] = offset_mask(square, KNIGHT_OFFSETS, 8);
+            tables.king[square] = offset_mask(square, KING_OFFSETS, 8);
+            tables.pawn[WHITE][square] = offset_mask(square, WHITE_PAWN_OFFSETS, 2);
+            tables.pawn[BLACK][square] = offset_mask(square, BLACK_PAWN_OFFSETS, 2);
+        }
+
+        // Along each of the eight directions from a square: every square reached
+        // gets the squares passed so far and the whole line (both ways) through both
+        for (int from = 0; from < 64; ++from)
+        {
+            for (int i = 0; i < 8; ++i)
+            {
+                int dr = KING_OFFSETS[i][0];
+                int df = KING_OFFSETS[i][1];
+                Bitboard line = square_bb(from);
+                for (int sign = -1; sign <= 1; sign += 2)
+                {
+                    for (int r = square_rank(from) + sign * dr, f = square_col(from) + sign * df; on_board(r, f); r += sign * dr, f += sign * df)
+                        line |= square_bb(r * 8 + f);
+                }
+
+                Bitboard passed = 0;
+                for (int r = square_rank(from) + dr, f = square_col(from) + df; on_board(r, f); r += dr, f += df)
+                {
+                    int to = r * 8 + f;
+                    tables.between[from][to] = passed;
+                    tables.line[from][to] = line;
+                    passed |= square_bb(to);
+                }
+            }
+        }
+        return tables;
+    }
+
+    // Attack table slices of all squares: 5248 bishop and 102400 rook entries
+    Bitboard bishop_table[5248];
+    Bitboard rook_table[102400];
+
+    // xorshift64*, reseeded per square from the rank's seed: these seeds are
+    // known to reach working magics after few candidates, keeping startup short
+    constexpr uint64_t MAGIC_SEEDS[8] = {728, 10316, 55013, 32803, 12281, 15100, 16645, 255};
+
+    struct MagicRandom
+    {
+        uint64_t state;
+
+        explicit MagicRandom(uint64_t seed) : state(seed) {}
+
+        uint64_t next()
+        {
+            state ^= state >> 12;
+            state ^= state << 25;
+            state ^= state >> 27;
+            return state * 2685821657736338717ULL;
+        }
+
+        // Few set bits make good magic candidates
+        uint64_t sparse() { return next() & next() & next(); }
+    };
+
+    // Sets up one slider's lookups: relevant masks, table slices and, without
+    // PEXT, a magic per square found by trying random candidates until no two
+    // occupancies with different attacks share an index
+    void init_magics(Magic magics[64], Bitboard* table, const int directions[][2])
+    {
+        static Bitboard occupancies[4096];
+        static Bitboard references[4096];
+
+        Bitboard* slice = table;
+        for (int square = 0; square < 64; ++square)
+        {
+            // Edge squares never block anything beyond them, unless the piece stands on that edge
+            Bitboard edges = ((RANK_1 | RANK_8) & ~(RANK_1 << (8 * square_rank(square))))
+                           | ((FILE_A | FILE_H) & ~(FILE_A << square_col(square)));
+            Magic& magic = magics[square];
+            magic.mask = ray_attacks(square, 0, directions) & ~edges;
+            magic.shift = 64 - pop_count(magic.mask);
+            magic.attacks = slice;
+
+            // Every subset of the mask (carry-rippler enumeration)
+            int size = 0;
+            Bitboard subset = 0;
+            do
+            {
+                occupancies[size] = subset;
+                references[size] = ray_attacks(square, subset, directions);
+                ++size;
+                subset = (subset - magic.mask) & magic.mask;
+            } while (subset);
+
+#ifdef __BMI2__
+            for (int i = 0; i < size; ++i)
+                slice[magic.index(occupancies[i])] = references[i];
+#else
+            static int epoch[4096];     // Attempt that last filled each slot
+            static int attempt = 0;
+            MagicRandom random(MAGIC_SEEDS[square_rank(square)]);
+            for (bool found = false; !found; )
+            {
+                do
+                    magic.magic = random.sparse();
+                while (pop_count((magic.mask * magic.magic) >> 56) < 6);
+
+                ++attempt;
+                found = true;
+                for (int i = 0; i < size && found; ++i)
+                {
+                    unsigned index = magic.index(occupancies[i]);
+                    if (epoch[index] != attempt)
+                    {
+                        epoch[index] = attempt;
+                        slice[index] = references[i];
+                    }
+                    else if (slice[index] != references[i])
+                        found = false;
+                }
+            }
+#endif
+            slice += size;
+        }
+    }
+
+    struct MagicInit
+    {
+        MagicInit()
+        {
+            init_magics(BISHOP_MAGICS, bishop_table, BISHOP_DIRECTIONS);
+            init_magics(ROOK_MAGICS, rook_table, ROOK_DIRECTIONS);
+        }
+    };
+}
+
+constexpr StepTables STEP_TABLES = make_step_tables();
+
+Magic BISHOP_MAGICS[64];
+Magic ROOK_MAGICS[64];
+
+namespace
+{
+    // After the magic arrays, which it fills
+    const MagicInit magic_init;
+}
@@ -1,24 +1,195 @@
 // board.cpp
 #include "board.hpp"
+#include <sstream>
+#include <cstring>
+#include <cctype>
+#include "instrument.hpp"
 
 Board::Board(bool enable_history) 
-    : board(8, std::vector<int>(8, EMPTY)), move_count(0),
-		turn(1), enable_history(enable_history) {}
+    : move_count(0), enable_history(enable_history)
+{
+    pos.clear();
+}
 
 void Board::initialize()
 {
-    // Initial position of the board
-    board[0] = {ROOK_WHITE, KNIGHT_WHITE, BISHOP_WHITE, QUEEN_WHITE, KING_WHITE, BISHOP_WHITE, KNIGHT_WHITE, ROOK_WHITE};
-    board[1] = {PAWN_WHITE, PAWN_WHITE, PAWN_WHITE, PAWN_WHITE, PAWN_WHITE, PAWN_WHITE, PAWN_WHITE, PAWN_WHITE};
+    // Initial position of the board, white on ranks 1 and 2
+    const int back_rank[8] = {ROOK_WHITE, KNIGHT_WHITE, BISHOP_WHITE, QUEEN_WHITE, KING_WHITE, BISHOP_WHITE, KNIGHT_WHITE, ROOK_WHITE};
 
-    board[7] = {ROOK_BLACK, KNIGHT_BLACK, BISHOP_BLACK, QUEEN_BLACK, KING_BLACK, BISHOP_BLACK, KNIGHT_BLACK, ROOK_BLACK};
-    board[6] = {PAWN_BLACK, PAWN_BLACK, PAWN_BLACK, PAWN_BLACK, PAWN_BLACK, PAWN_BLACK, PAWN_BLACK, PAWN_BLACK};
+    pos.clear();
+    for (int col = 0; col < 8; ++col)
+    {
+        pos.add_piece(back_rank[col], make_square(7, col));
+        pos.add_piece(PAWN_WHITE, make_square(6, col));
+        pos.add_piece(-back_rank[col], make_square(0, col));
+        pos.add_piece(PAWN_BLACK, make_square(1, col));
+    }
+    pos.castling = ALL_CASTLING;
+    pos.key = pos.compute_key();
 
 	move_count = 0;
-    turn = 1;
-    fifty_move_counter = 0;
-    position_history.clear();
-    history.clear();
+    undo_size = 0;
+    history.clear(move_count);
+}
+
+// Loads a position in Forsyth-Edwards Notation; leaves the board untouched on bad input
+bool Board::from_fen(const std::string& fen)
+{
+    std::istringstream stream(fen);
+    std::string placement, side, castling = "-", en_passant = "-";
+    int halfmove = 0, fullmove = 1;
+    if (!(stream >> placement >> side))
+        return false;
+    stream >> castling >> en_passant >> halfmove >> fullmove;
+
+    Position next;
+    next.clear();
+    int x = 0, y = 0;
+    for (char c : placement)
+    {
+        // Every rank must describe exactly eight squares
+        if (c == '/')
+        {
+            if (y != 8)
+                return false;
+            ++x;
+            y = 0;
+        }
+        else if (c >= '1' && c <= '8')
+        {
+            y += c - '0';
+            if (y > 8)
+                return false;
+        }
+        else
+        {
+            const char* symbols = "PNBRQK";
+            const char* found = std::strchr(symbols, std::toupper(c));
+            if (!found || !*found || x > 7 || y > 7)
+                return false;
+            int piece = static_cast<int>(found - symbols) + 1;
+            next.add_piece(std::isupper(c) ? piece : -piece, make_square(x, y++));
+        }
+    }
+    // More than 32 pieces cannot come from a game, nor fit a packed record
+    if (x != 7 || y != 8 || !next.pieces_of(KING_WHITE) || !next.pieces_of(KING_BLACK) ||
+        pop_count(next.occupied) > 32 || next.pawns_on_back_ranks())
+        return false;
+
+    if (side != "w" && side != "b")
+        return false;
+    next.turn = side == "b" ? -1 : 1;
+
+    // The side that just moved cannot have left its king in check
+    if (is_square_attacked(next, next.king_square(-next.turn), next.turn))
+        return false;
+
+    for (char c : castling)
+    {
+        switch (c)
+        {
+            case 'K': next.castling |= WHITE_OO; break;
+            case 'Q': next.castling |= WHITE_OOO; break;
+            case 'k': next.castling |= BLACK_OO; break;
+            case 'q': next.castling |= BLACK_OOO; break;
+        }
+    }
+    // Rights without the king and rook at home are dropped, as make_move would have
+    next.castling &= next.castling_possible();
+
+    // Keep the en passant square only when a pawn can take, as make_move does
+    if (en_passant.size() == 2)
+    {
+        auto [ep_x, ep_y] = chess_to_index(en_passant);
+        int square = make_square(ep_x, ep_y);
+        if (square >= 0 && square < 64 &&
+            (pawn_attacks(color_index(-next.turn), square) & next.pieces_of(PAWN_WHITE * next.turn)))
+            next.en_passant = static_cast<int8_t>(square);
+    }
+
+    next.fifty_move_counter = halfmove;
+    next.key = next.compute_key();
+
+    pos = next;
+    undo_size = 0;
+    move_count = std::max(0, (fullmove - 1) * 2 + (next.turn == -1 ? 1 : 0));
+    history.clear(move_count);
+    return true;
+}
+
+// Writes the position in Forsyth-Edwards Notation
+std::string Board::to_fen() const
+{
+    std::string fen;
+    for (int x = 0; x < 8; ++x)
+    {
+        int empty = 0;
+        for (int y = 0; y < 8; ++y)
+        {
+            int piece = pos.piece_on(make_square(x, y));
+            if (piece == EMPTY)
+            {
+                ++empty;
+                continue;
+            }
+            if (empty)
+                fen += static_cast<char>('0' + empty);
+            empty = 0;
+            char symbol = "PNBRQK"[piece_type(piece) - 1];
+            fen += piece > 0 ? symbol : static_cast<char>(std::tolower(symbol));
+        }
+        if (empty)
+            fen += static_cast<char>('0' + empty);
+        if (x < 7)
+            fen += '/';
+    }
+
+    fen += pos.turn == 1 ? " w " : " b ";
+    if (pos.castling & WHITE_OO) fen += 'K';
+    if (pos.castling & WHITE_OOO) fen += 'Q';
+    if (pos.castling & BLACK_OO) fen += 'k';
+    if (pos.castling & BLACK_OOO) fen += 'q';
+    if (!pos.castling)
+        fen += '-';
+
+    if (pos.en_passant != NO_SQUARE)
+    {
+        std::string square = index_to_chess(square_row(pos.en_passant), square_col(pos.en_passant));
+        fen += " " + std::string{static_cast<char>(std::tolower(square[0])), square[1]};
+    }
+    else
+        fen += " -";
+
+    return fen + " " + std::to_string(pos.fifty_move_counter) + " " + std::to_string(get_fullmove_number());
+}
+
+bool Board::pack(PackedPosition& packed) const
+{
+    return pack_position(pos, get_fullmove_number(), packed);
+}
+
+// Like from_fen, the game history starts over at the unpacked position;
+// a corrupt record is rejected and leaves the board as it was
+bool Board::unpack(const PackedPosition& packed)
+{
+    Position next;
+    int fullmove;
+    if (!unpack_position(packed, next, fullmove))
+        return false;
+
+    pos = next;
+    undo_size = 0;
+    move_count = std::max(0, (fullmove - 1) * 2 + (pos.turn == -1 ? 1 : 0));
+    history.clear(move_count);
+    return true;
+}
+
+void Board::set_position(const Position& position)
+{
+    pos = position;
+    undo_size = 0;
+    move_count = pos.turn == -1 ? 1 : 0;
+    history.clear(move_count);
 }
 
 void Board::display() const
@@ -47,7 +218,7 @@ void Board::display() const
         std::cout << 8 - i << " "; // Row label (8 to 1)
         for (int j = 0; j < 8; ++j)
         {
-            int cell = board[i][j];
+            int cell = get_piece(i, j);
 
             // Determine the symbol and color for the piece or empty square
             std::string piece = (cell == EMPTY) ? " " : piece_symbols.at(cell);
@@ -63,7 +234,7 @@ void Board::display() const
 
     // Print column labels at the bottom
     std::cout << "    A   B   C   D   E   F   G   H\n";
-    std::cout << "Turn: " << (turn == 1 ? "White" : "Black") << ", Move count: " << move_count << "\n";
+    std::cout << "Turn: " << (pos.turn == 1 ? "White" : "Black") << ", Move count: " << move_count << "\n";
 }
 
 void Board::set_history_enabled(bool enable)
@@ -75,7 +246,7 @@ void Board::set_history_enabled(bool enable)
 
 bool Board::is_valid_move(int x1, int y1, int x2, int y2, int player) const
 {
-    int piece = board[x1][y1];
+    int piece = get_piece(x1, y1);
     if ((player == 1 && piece < 0) || (player == -1 && piece > 0))
 	{
         std::cout << "You can only move your own pieces.\n";
@@ -87,54 +258,191 @@ bool Board::is_valid_move(int x1, int y1, int x2, int y2, int player) const
 // Helper function to find the player's king position on the board
 std::pair<int, int> Board::find_king_position(int player) const
 {
-    for (int x = 0; x < 8; ++x)
-	{
-        for (int y = 0; y < 8; ++y)
-		{
-            if (get_piece(x, y) == (player == 1 ? KING_WHITE : KING_BLACK))
-			{
-                return {x, y};
-            }
-        }
-    }
-    return {-1, -1}; // King not found (shouldn't happen in a valid game)
+    int square = pos.king_square(player);
+    if (square == NO_SQUARE)
+        return {-1, -1}; // King not found (shouldn't happen in a valid game)
+    return {square_row(square), square_col(square)};
 }
 
 // Checks if the player's king is in check
 bool Board::is_in_check(int player) const
 {
-    auto [king_x, king_y] = find_king_position(player);
-    if (king_x == -1 || king_y == -1) return false;
+    INSTRUMENT_SCOPE(Probe::IsInCheck);
+    int king = pos.king_square(player);
+    if (king == NO_SQUARE) return false;
 
-    int opponent = -player;
-    for (int x = 0; x < 8; ++x)
-	{
-        for (int y = 0; y < 8; ++y)
-		{
-            if ((opponent == 1 && get_piece(x, y) > 0) || 
-                (opponent == -1 && get_piece(x, y) < 0))
-			{
-                auto moves = get_moves(x, y, get_board());
-                for (const auto& move : moves)
-				{
-                    if (move.first == king_x && move.second == king_y)
-					{
-                        return true;
-                    }
-                }
-            }
+    return player > 0 ? attacked_by<BLACK>(pos, king, pos.occupied) : attacked_by<WHITE>(pos, king, pos.occupied);
+}
+
+// Castling rights lost when a piece leaves or lands on the square
+static int castling_mask(int square)
+{
+    switch (square)
+    {
+        case 0:  return ALL_CASTLING & ~WHITE_OOO;
+        case 4:  return ALL_CASTLING & ~(WHITE_OO | WHITE_OOO);
+        case 7:  return ALL_CASTLING & ~WHITE_OO;
+        case 56: return ALL_CASTLING & ~BLACK_OOO;
+        case 60: return ALL_CASTLING & ~(BLACK_OO | BLACK_OOO);
+        case 63: return ALL_CASTLING & ~BLACK_OO;
+    }
+    return ALL_CASTLING;
+}
+
+// Plays a pseudo-legal move and pushes what is needed to take it back
+void Board::make_move(Move move)
+{
+    int from = move.from();
+    int to = move.to();
+    int flags = move.flags();
+    int player = pos.turn;
+    bool is_pawn = piece_type(pos.piece_on(from)) == PAWN_WHITE;
+
+    UndoInfo& undo = undo_stack[undo_size++];
+    undo.move = move;
+    undo.captured = EMPTY;
+    undo.castling = pos.castling;
+    undo.en_passant = pos.en_passant;
+    undo.fifty_move_counter = pos.fifty_move_counter;
+    undo.key = pos.key;
+
+    if (flags == MOVE_EN_PASSANT)
+    {
+        undo.captured = PAWN_WHITE * -player;
+        pos.remove_piece(to - 8 * player); // Pawn captured en passant
+    }
+    else if (move.is_capture())
+    {
+        undo.captured = pos.piece_on(to);
+        pos.remove_piece(to);
+    }
+
+    pos.relocate_piece(from, to);
+
+    if (move.is_promotion())
+    {
+        pos.remove_piece(to);
+        pos.add_piece(move.promotion_type() * player, to);
+    }
+    else if (flags == MOVE_KING_CASTLE)
+        pos.relocate_piece(to + 1, to - 1); // Rook h-file to f-file
+    else if (flags == MOVE_QUEEN_CASTLE)
+        pos.relocate_piece(to - 2, to + 1); // Rook a-file to d-file
+
+    // En passant is only recorded when an enemy pawn can actually take,
+    // so positions that differ only by a dead en passant square hash alike
+    if (pos.en_passant != NO_SQUARE)
+        pos.key ^= ZOBRIST.en_passant[square_col(pos.en_passant)];
+    pos.en_passant = NO_SQUARE;
+    if (flags == MOVE_DOUBLE_PUSH)
+    {
+        int passed = (from + to) / 2;
+        if (pawn_attacks(color_index(player), passed) & pos.pieces_of(PAWN_WHITE * -player))
+        {
+            pos.en_passant = passed;
+            pos.key ^= ZOBRIST.en_passant[square_col(passed)];
         }
     }
-    return false;
+
+    pos.key ^= ZOBRIST.castling[pos.castling];
+    pos.castling &= castling_mask(from) & castling_mask(to);
+    pos.key ^= ZOBRIST.castling[pos.castling];
+
+    // Handle 50-move rule
+    if (is_pawn || move.is_capture())
+        pos.fifty_move_counter = 0; // Reset the 50-move counter
+    else
+        ++pos.fifty_move_counter; // Increment if no pawn move or capture
+
+    pos.turn = -player;
+    pos.key ^= ZOBRIST.side;
+    ++move_count;
+}
+
+// Restores the position from the top of the undo stack
+void Board::unmake_move()
+{
+    if (undo_size == 0)
+        return;
+
+    const UndoInfo& undo = undo_stack[--undo_size];
+    int from = undo.move.from();
+    int to = undo.move.to();
+    int flags = undo.move.flags();
+    int player = -pos.turn;
+
+    if (undo.move.is_promotion())
+    {
+        pos.remove_piece(to);
+        pos.add_piece(PAWN_WHITE * player, to);
+    }
+    else if (flags == MOVE_KING_CASTLE)
+        pos.relocate_piece(to - 1, to + 1);
+    else if (flags == MOVE_QUEEN_CASTLE)
+        pos.relocate_piece(to + 1, to - 2);
+
+    pos.relocate_piece(to, from);
+
+    if (undo.captured != EMPTY)
+        pos.add_piece(undo.captured, flags == MOVE_EN_PASSANT ? to - 8 * player : to);
+
+    pos.castling = undo.castling;
+    pos.en_passant = undo.en_passant;
+    pos.fifty_move_counter = undo.fifty_move_counter;
+    pos.key = undo.key;
+    pos.turn = player;
+    --move_count;
 }
 
-bool Board::move_piece(const std::string& from, const std::string& to)
+// The fifty-move counter restarts so repetition checks stop at the null move:
+// positions before it are not reachable by the moves actually played
+void Board::make_null_move()
 {
+    UndoInfo& undo = undo_stack[undo_size++];
+    undo.move = NULL_MOVE;
+    undo.captured = EMPTY;
+    undo.castling = pos.castling;
+    undo.en_passant = pos.en_passant;
+    undo.fifty_move_counter = pos.fifty_move_counter;
+    undo.key = pos.key;
+
+    if (pos.en_passant != NO_SQUARE)
+        pos.key ^= ZOBRIST.en_passant[square_col(pos.en_passant)];
+    pos.en_passant = NO_SQUARE;
+    pos.fifty_move_counter = 0;
+    pos.turn = -pos.turn;
+    pos.key ^= ZOBRIST.side;
+    ++move_count;
+}
+
+void Board::unmake_null_move()
+{
+    const UndoInfo& undo = undo_stack[--undo_size];
+    pos.en_passant = undo.en_passant;
+    pos.fifty_move_counter = undo.fifty_move_counter;
+    pos.key = undo.key;
+    pos.turn = -pos.turn;
+    --move_count;
+}
+
+static int promotion_from_char(char promotion)
+{
+    switch (std::toupper(promotion))
+    {
+        case 'N': return KNIGHT_WHITE;
+        case 'B': return BISHOP_WHITE;
+        case 'R': return ROOK_WHITE;
+    }
+    return QUEEN_WHITE;
+}
+
+bool Board::move_piece(const std::string& from, const std::string& to, char promotion)
+{
+        INSTRUMENT_SCOPE(Probe::MovePiece);
         auto [x1, y1] = chess_to_index(from);
         auto [x2, y2] = chess_to_index(to);
 
-        int moving_piece = board[x1][y1];
-        int target_piece = board[x2][y2];
+        int moving_piece = get_piece(x1, y1);
 
         if (moving_piece == EMPTY)
         {
@@ -143,58 +451,43 @@ bool Board::move_piece(const std::string& from, const std::string& to)
         }
 
         // Check if it's the player's turn and if the move is valid
-        if (!is_valid_move(x1, y1, x2, y2, turn)) return false;
+        if (!is_valid_move(x1, y1, x2, y2, pos.turn)) return false;
 
-        auto moves = get_moves(x1, y1, board);
+        MoveList moves;
+        get_moves(x1, y1, pos, moves);
+        Move move = encode_move(pos, make_square(x1, y1), make_square(x2, y2), promotion_from_char(promotion));
 
         // Ensure the target square is a valid move
-        if (std::find(moves.begin(), moves.end(), std::make_pair(x2, y2)) == moves.end())
+        if (!moves.contains(move))
         {
             std::cout << "Invalid move for this piece.\n";
             return false;
         }
 
-        // Simulate the move on a temporary board to check for self-check
-        Board temp_board = *this;
-        temp_board.board[x2][y2] = moving_piece;
-        temp_board.board[x1][y1] = EMPTY;
+        // Play the move and take it back if it leaves the king in check
+        int player = pos.turn;
+        make_move(move);
+        int captured = undo_stack[undo_size - 1].captured;
 
-        if (is_in_check(turn))
+        if (is_in_check(player))
         {
+            unmake_move();
             std::cout << "Move would leave the king in check.\n";
             return false;
         }
 
-        // If the simulated move does not leave the player in check, execute it
-        board[x2][y2] = moving_piece;
-        board[x1][y1] = EMPTY;
-
-        // Handle 50-move rule and threefold repetition tracking
-        if (moving_piece == PAWN_WHITE || moving_piece == PAWN_BLACK || target_piece != EMPTY)
-            fifty_move_counter = 0; // Reset the 50-move counter
-        else
-            ++fifty_move_counter; // Increment if no pawn move or capture
-
-        // Track the board state for threefold repetition
-        std::string state = board_to_string();
-        ++position_history[state];
-
-        // Record history if enabled
-        if (enable_history)
+        // Game moves stay on the undo stack as the repetition history,
+        // which never needs to reach past an irreversible move
+        if (pos.fifty_move_counter == 0)
+            undo_size = 0;
+        else if (undo_size > MAX_UNDO / 2)
         {
-            MoveRecord record;
-            record.move_number = ++move_count;
-            record.from = from;
-            record.to = to;
-            record.player = turn;
-            record.timestamp = std::chrono::steady_clock::now();
-            history.push_back(record);
+            std::copy(undo_stack.begin() + MAX_UNDO / 4, undo_stack.begin() + undo_size, undo_stack.begin());
+            undo_size -= MAX_UNDO / 4;
         }
-        else
-            ++move_count;
 
-        // Toggle the turn
-        turn = -turn;
+        if (enable_history)
+            history.record(move, moving_piece, captured);
 
         return true;
 }
@@ -208,40 +501,71 @@ void Board::show_history() const
         return;
     }
 
+    // Squares are only turned into text here, not when the moves are played
     std::cout << "\nMove History:\n";
-    for (const auto& record : history)
+    for (int i = 0; i < history.size(); ++i)
 	{
-        std::cout << "Move " << record.move_number << " by " 
-                  << (record.player == 1 ? "White" : "Black") << ": " 
-                  << record.from << " to " << record.to << "\n";
+        const MoveRecord& record = history[i];
+        Move move = record.move;
+        std::cout << "Move " << history.ply(i) << " by "
+                  << (record.piece > 0 ? "White" : "Black") << ": "
+                  << index_to_chess(square_row(move.from()), square_col(move.from())) << " to "
+                  << index_to_chess(square_row(move.to()), square_col(move.to()));
+        if (record.captured != EMPTY)
+            std::cout << " takes " << "PNBRQK"[piece_type(record.captured) - 1];
+        if (move.is_promotion())
+            std::cout << " =" << "NBRQ"[move.promotion_type() - KNIGHT_WHITE];
+        std::cout << " (+" << std::fixed << std::setprecision(3) << record.elapsed_us / 1e6 << " s)\n";
     }
 }
 
 // Returns the piece at the given board coordinates
 int Board::get_piece(int x, int y) const
 {
-    return board[x][y];
+    return pos.piece_on(make_square(x, y));
 }
 
-// Returns a const reference to the board matrix
-const std::vector<std::vector<int>>& Board::get_board() const
+// Builds a grid copy of the position (row 0 is rank 8)
+std::vector<std::vector<int>> Board::get_board() const
 {
-    return board;
+    std::vector<std::vector<int>> grid(8, std::vector<int>(8, EMPTY));
+    for (int x = 0; x < 8; ++x)
+    {
+        for (int y = 0; y < 8; ++y)
+            grid[x][y] = get_piece(x, y);
+    }
+    return grid;
 }
 
 std::string Board::board_to_string() const
 {
     std::string state;
-    for (const auto& row : board)
+    for (int square = 0; square < 64; ++square)
+        state += std::to_string(pos.piece_on(square)) + ",";
+    return state + " turn: " + std::to_string(pos.turn);
+}
+
+// Compares keys on the undo stack, only back to the last capture or pawn move
+bool Board::is_threefold_repetition() const
+{
+    int bound = std::min(pos.fifty_move_counter, undo_size);
+    int repetitions = 1;
+    for (int i = 2; i <= bound; i += 2)
     {
-        for (const auto& piece : row)
-            state += std::to_string(piece) + ",";
+        if (undo_stack[undo_size - i].key == pos.key && ++repetitions >= 3)
+            return true;
     }
-    return state + " turn: " + std::to_string(turn);
+    return false;
 }
 
-bool Board::is_threefold_repetition() const
+// Any earlier occurrence counts; search treats a repeated position as a draw
+bool Board::is_repetition() const
 {
-    auto state = board_to_string();
-    return position_history[state] >= 3;
-}
\ No newline at end of file
+    int bound = std::min(pos.fifty_move_counter, undo_size);
+    for (int i = 4; i <= bound; i += 2)
+    {
+        if (undo_stack[undo_size - i].key == pos.key)
+            return true;
+    }
+    return false;
+}
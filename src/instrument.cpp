@@ -0,0 +1,172 @@
+// instrument.cpp
+#include "instrument.hpp"
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+    const char* PROBE_NAMES[] =
+        {"generate_legal_moves", "is_in_check", "move_piece", "is_checkmate", "is_stalemate", "evaluate", "search"};
+
+    static_assert(sizeof(PROBE_NAMES) / sizeof(PROBE_NAMES[0]) == static_cast<int>(Probe::Count), "Every probe needs a name");
+}
+
+#ifdef CHESS_INSTRUMENT
+
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    // Shards outlive their threads, so counters of finished workers still count
+    struct Registry
+    {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<InstrumentShard>> shards;
+    };
+
+    Registry& registry()
+    {
+        static Registry instance;
+        return instance;
+    }
+
+    // $CHESS_METRICS, or chess_metrics.json in the working directory
+    void dump_at_exit()
+    {
+        const char* path = std::getenv("CHESS_METRICS");
+        instrument_dump_file(path && *path ? path : "chess_metrics.json");
+    }
+
+    // Counter ticks per nanosecond, measured against the steady clock
+    double ticks_per_ns()
+    {
+        static double ratio = 0.0;
+        if (ratio == 0.0)
+        {
+            Clock::time_point start = Clock::now();
+            uint64_t ticks = instrument_cycles();
+            while (Clock::now() - start < std::chrono::milliseconds(10))
+                ;
+            double elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+            ratio = (instrument_cycles() - ticks) / elapsed;
+        }
+        return ratio;
+    }
+
+    // Upper bound of the bucket holding the q-quantile
+    uint64_t histogram_quantile(const uint64_t* histogram, uint64_t calls, double q)
+    {
+        uint64_t target = static_cast<uint64_t>(q * calls);
+        uint64_t seen = 0;
+        for (int bucket = 0; bucket < HISTOGRAM_BUCKETS; ++bucket)
+        {
+            seen += histogram[bucket];
+            if (seen > target)
+                return uint64_t(2) << bucket;
+        }
+        return uint64_t(2) << (HISTOGRAM_BUCKETS - 1);
+    }
+}
+
+InstrumentShard& instrument_shard()
+{
+    thread_local InstrumentShard* shard = nullptr;
+    if (!shard)
+    {
+        Registry& shared = registry();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        if (shared.shards.empty())
+            std::atexit(dump_at_exit);
+        shared.shards.push_back(std::make_unique<InstrumentShard>());
+        shard = shared.shards.back().get();
+    }
+    return *shard;
+}
+
+void instrument_dump(std::ostream& out)
+{
+    Registry& shared = registry();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    double ratio = ticks_per_ns();
+
+    out << "{\n  \"enabled\": true,\n  \"threads\": " << shared.shards.size()
+        << ",\n  \"ticks_per_ns\": " << ratio << ",\n  \"probes\": {";
+    for (int probe = 0; probe < PROBE_COUNT; ++probe)
+    {
+        // Shards merge by summing
+        uint64_t calls = 0, cycles = 0, histogram[HISTOGRAM_BUCKETS] = {};
+        for (const auto& shard : shared.shards)
+        {
+            const InstrumentShard::Counters& counters = shard->probes[probe];
+            calls += counters.calls.load(std::memory_order_relaxed);
+            cycles += counters.cycles.load(std::memory_order_relaxed);
+            for (int bucket = 0; bucket < HISTOGRAM_BUCKETS; ++bucket)
+                histogram[bucket] += counters.histogram[bucket].load(std::memory_order_relaxed);
+        }
+
+        out << (probe ? "," : "") << "\n    \"" << PROBE_NAMES[probe] << "\": {\"calls\": " << calls
+            << ", \"ticks\": " << cycles
+            << ", \"mean_ns\": " << (calls ? cycles / ratio / calls : 0.0)
+            << ", \"p50_ns\": " << (calls ? histogram_quantile(histogram, calls, 0.50) / ratio : 0.0)
+            << ", \"p99_ns\": " << (calls ? histogram_quantile(histogram, calls, 0.99) / ratio : 0.0)
+            << ", \"histogram\": {";
+        // Keyed by the bucket's lower bound in ticks
+        bool first = true;
+        for (int bucket = 0; bucket < HISTOGRAM_BUCKETS; ++bucket)
+        {
+            if (!histogram[bucket])
+                continue;
+            out << (first ? "" : ", ") << "\"" << (uint64_t(1) << bucket) << "\": " << histogram[bucket];
+            first = false;
+        }
+        out << "}}";
+    }
+    out << "\n  }\n}\n";
+}
+
+void instrument_reset()
+{
+    Registry& shared = registry();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    for (const auto& shard : shared.shards)
+    {
+        for (auto& counters : shard->probes)
+        {
+            counters.calls.store(0, std::memory_order_relaxed);
+            counters.cycles.store(0, std::memory_order_relaxed);
+            for (auto& bucket : counters.histogram)
+                bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+#else
+
+void instrument_dump(std::ostream& out)
+{
+    out << "{\n  \"enabled\": false\n}\n";
+}
+
+void instrument_reset()
+{
+}
+
+#endif // CHESS_INSTRUMENT
+
+bool instrument_dump_file(const std::string& path)
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        std::cerr << "Could not write metrics to " << path << "\n";
+        return false;
+    }
+    instrument_dump(file);
+    return true;
+}
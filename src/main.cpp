@@ -1,36 +1,21 @@
 // main.cpp
 #include <iostream>
 #include <thread>
-#include <cstdlib>     // for std::rand and std::srand
-#include <ctime>       // for std::time
 #include "board.hpp"
 #include "moves.hpp"
 #include "ai.hpp"
+#include "book.hpp"
+#include "tablebase.hpp"
 #include "validation.hpp"
+#include "movegen.hpp"
+#include "perft.hpp"
+#include "microbench.hpp"
+#include "nnue.hpp"
+#include "selfplay.hpp"
+#include "uci.hpp"
 
-// Function to get all possible moves for a player
-std::vector<std::pair<std::string, std::string>> get_all_moves(Board& board, int player)
-{
-    std::vector<std::pair<std::string, std::string>> moves;
-    for (int x = 0; x < 8; ++x)
-    {
-        for (int y = 0; y < 8; ++y)
-        {
-            if ((player == 1 && board.get_piece(x, y) > 0) ||
-                (player == -1 && board.get_piece(x, y) < 0))
-            {
-                auto possible_moves = get_moves(x, y, board.get_board());
-                for (const auto& move : possible_moves)
-                {
-                    std::string from = index_to_chess(x, y);
-                    std::string to = index_to_chess(move.first, move.second);
-                    moves.emplace_back(from, to);
-                }
-            }
-        }
-    }
-    return moves;
-}
+// Time the engine spends on each move of the auto-played game
+constexpr int64_t AUTO_GAME_MOVE_TIME_MS = 250;
 
 void play_auto_game(Board& board)
 {
@@ -58,23 +43,39 @@ void play_auto_game(Board& board)
             break;
         }
 
-        // Get all possible moves for the current player
-        auto moves = get_all_moves(board, turn);
+        // A position the tablebases know is decided: no need to play it out
+        TBResult outcome;
+        if (TABLEBASES.probe(board.get_position(), outcome)) {
+            if (outcome.wdl == 0)
+                std::cout << "The game is a draw by tablebase adjudication.\n";
+            else
+                std::cout << (outcome.wdl * turn > 0 ? "White" : "Black") << " wins by tablebase adjudication (mate in "
+                          << (outcome.dtm + 1) / 2 << ").\n";
+            break;
+        }
+
+        // Let the engine choose the move for the current player
+        SearchLimits limits;
+        limits.time_ms = AUTO_GAME_MOVE_TIME_MS;
+        SearchResult result = select_best_move(board, limits);
 
         // If no moves are available and not in checkmate or stalemate, end the game
-        if (moves.empty()) {
+        if (result.best_move == NULL_MOVE) {
             std::cout << "The game is a draw (no moves available).\n";
             break;
         }
 
-        // Select a random move from the available moves
-        std::pair<std::string, std::string> selected_move = moves[std::rand() % moves.size()];
+        Move selected = result.best_move;
+        std::string from = index_to_chess(square_row(selected.from()), square_col(selected.from()));
+        std::string to = index_to_chess(square_row(selected.to()), square_col(selected.to()));
+        char promotion = selected.is_promotion() ? "NBRQ"[selected.promotion_type() - KNIGHT_WHITE] : 'Q';
 
         // Apply the selected move
-        if (board.move_piece(selected_move.first, selected_move.second)) {
+        if (board.move_piece(from, to, promotion)) {
             std::cout << "Move " << ++move_count << ": " 
                       << (turn == 1 ? "White" : "Black") << " plays " 
-                      << selected_move.first << " to " << selected_move.second << "\n";
+                      << from << " to " << to << " (score " << result.score
+                      << ", depth " << result.stats.depth << ", " << result.stats.nps << " nodes/s)\n";
         } else {
             std::cout << "Failed move attempt. Invalid move detected.\n";
             break;
@@ -85,13 +86,48 @@ std::this_thread::sleep_for(std::chrono::milliseconds(500));
     }
 }
 
-int main()
+int main(int argc, char* argv[])
 {
+    std::vector<std::string> args(argv + 1, argv + argc);
+    if (!args.empty() && (args[0] == "perft" || args[0] == "divide"))
+        return perft_command(args);
+    if (!args.empty() && args[0] == "bench")
+        return microbench_command(args);
+    if (!args.empty() && args[0] == "smpbench")
+        return smp_bench_command(args);
+    if (!args.empty() && args[0] == "uci")
+        return uci_loop();
+    if (!args.empty() && args[0] == "selfplay")
+        return selfplay_command(args);
+    if (!args.empty() && args[0] == "featurebench")
+        return feature_bench_command(args);
+    if (!args.empty() && args[0] == "nnuebench")
+        return nnue_bench_command(args);
+    if (!args.empty() && args[0] == "book")
+        return book_command(args);
+    if (!args.empty() && args[0] == "tbgen")
+        return tbgen_command(args);
+    if (!args.empty() && args[0] == "tbprobe")
+        return tbprobe_command(args);
 
-    std::srand(static_cast<unsigned>(std::time(nullptr))); // Seed for random move selection
+    // Auto game options: -b <book.bin> opens from a Polyglot book,
+    // -e <dir> plays and adjudicates endgames from the tablebases
+    for (size_t i = 0; i + 1 < args.size(); i += 2)
+    {
+        if (args[i] == "-b" && !BOOK.open(args[i + 1]))
+        {
+            std::cerr << "Could not open book " << args[i + 1] << "\n";
+            return 1;
+        }
+        if (args[i] == "-e" && TABLEBASES.load(args[i + 1]) == 0)
+        {
+            std::cerr << "No tablebases in " << args[i + 1] << "\n";
+            return 1;
+        }
+    }
 
-    // Initialize board without history to speed up simulation
-    Board board(false);
+    // The move history is a fixed ring of packed records, cheap enough to keep on
+    Board board;
     board.initialize();
 
     play_auto_game(board);
@@ -0,0 +1,365 @@
+// microbench.cpp
+#include "microbench.hpp"
+#include "bitboard.hpp"
+#include "board.hpp"
+#include "movegen.hpp"
+#include "validation.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    // Hand-picked positions: the perft references plus checks, mates and bare endgames
+    const char* CORPUS_FENS[] =
+    {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        "rnb1kbnr/pppp1ppp/8/4p3/6Pq/5P2/PPPPP2P/RNBQKBNR w KQkq - 1 3",
+        "r1bqkb1r/pppp1Qpp/2n2n2/4p3/2B1P3/8/PPPP1PPP/RNB1K1NR b KQkq - 0 4",
+        "4k3/8/8/8/8/8/8/4KB2 w - - 0 1",
+        "8/8/4k3/8/2K5/8/3Q4/8 b - - 5 60",
+        "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1",
+        "8/5k2/8/3n4/8/2B5/4K3/8 w - - 10 70",
+    };
+
+    // Positions taken from seeded random games, so every run sees the same corpus
+    constexpr int RANDOM_POSITIONS = 244;
+    constexpr int SAMPLE_EVERY = 5;
+
+    // A sample runs its pass often enough to last this long, far above the clock resolution
+    constexpr double MIN_SAMPLE_NS = 100000.0;
+
+    // Keeps results alive so the optimizer cannot drop the calls
+    volatile uint64_t sink = 0;
+
+    struct Benchmark
+    {
+        const char* name;
+        size_t calls;                       // Calls made by one pass
+        std::function<uint64_t()> pass;     // Returns a checksum of the results
+    };
+
+    // One piece on one square of a corpus position
+    struct PieceSite
+    {
+        const Position* pos;
+        int x;
+        int y;
+        bool is_white;
+    };
+
+    // A game move for move_piece, played and taken back on its own board
+    struct GameMove
+    {
+        Board* board;
+        std::string from;
+        std::string to;
+    };
+
+    std::vector<Board> build_corpus()
+    {
+        std::vector<Board> boards;
+        for (const char* fen : CORPUS_FENS)
+        {
+            Board board;
+            board.from_fen(fen);
+            boards.push_back(board);
+        }
+
+        // Played with make_move, so the undo stack holds a real repetition history
+        std::mt19937 generator(23);
+        Board board;
+        int sampled = 0;
+        while (sampled < RANDOM_POSITIONS)
+        {
+            board.initialize();
+            for (int ply = 0; ply < 160 && sampled < RANDOM_POSITIONS; ++ply)
+            {
+                MoveList moves;
+                generate_legal_moves(board, moves);
+                if (moves.empty())
+                    break;
+                board.make_move(moves[generator() % moves.size()]);
+                if (ply % SAMPLE_EVERY == SAMPLE_EVERY - 1)
+                {
+                    boards.push_back(board);
+                    ++sampled;
+                }
+            }
+        }
+        return boards;
+    }
+
+    std::vector<Benchmark> build_benchmarks(std::vector<Board>& boards)
+    {
+        // Piece sites by type, pawns first
+        std::vector<PieceSite> sites[6];
+        std::vector<GameMove> game_moves;
+        for (Board& board : boards)
+        {
+            const Position& pos = board.get_position();
+            for (int x = 0; x < 8; ++x)
+            {
+                for (int y = 0; y < 8; ++y)
+                {
+                    int piece = board.get_piece(x, y);
+                    if (piece != EMPTY)
+                        sites[piece_type(piece) - 1].push_back({&pos, x, y, piece > 0});
+                }
+            }
+
+            // A reversible move keeps the undo entry that takes it back
+            MoveList moves;
+            generate_legal_moves(board, moves);
+            for (Move move : moves)
+            {
+                if (piece_type(pos.piece_on(move.from())) != PAWN_WHITE && !move.is_capture() && !move.is_castle())
+                {
+                    game_moves.push_back({&board, index_to_chess(square_row(move.from()), square_col(move.from())),
+                                          index_to_chess(square_row(move.to()), square_col(move.to()))});
+                    break;
+                }
+            }
+        }
+
+        std::vector<std::string> square_names;
+        for (int x = 0; x < 8; ++x)
+        {
+            for (int y = 0; y < 8; ++y)
+                square_names.push_back(index_to_chess(x, y));
+        }
+
+        typedef void (*PieceMoves)(int, int, const Position&, MoveList&);
+        auto piece_moves = [&](int type, PieceMoves generate)
+        {
+            return [list = sites[type - 1], generate]()
+            {
+                uint64_t checksum = 0;
+                MoveList moves;
+                for (const PieceSite& site : list)
+                {
+                    moves.clear();
+                    generate(site.x, site.y, *site.pos, moves);
+                    checksum += moves.size();
+                }
+                return checksum;
+            };
+        };
+
+        std::vector<Benchmark> benchmarks;
+        benchmarks.push_back({"chess_to_index", square_names.size(), [square_names]()
+        {
+            uint64_t checksum = 0;
+            for (const std::string& name : square_names)
+            {
+                auto [x, y] = chess_to_index(name);
+                checksum += x * 8 + y;
+            }
+            return checksum;
+        }});
+        benchmarks.push_back({"index_to_chess", 64, []()
+        {
+            uint64_t checksum = 0;
+            for (int x = 0; x < 8; ++x)
+            {
+                for (int y = 0; y < 8; ++y)
+                    checksum += index_to_chess(x, y)[0];
+            }
+            return checksum;
+        }});
+
+        benchmarks.push_back({"get_pawn_moves", sites[PAWN_WHITE - 1].size(), [pawns = sites[PAWN_WHITE - 1]]()
+        {
+            uint64_t checksum = 0;
+            MoveList moves;
+            for (const PieceSite& site : pawns)
+            {
+                moves.clear();
+                get_pawn_moves(site.x, site.y, *site.pos, site.is_white, moves);
+                checksum += moves.size();
+            }
+            return checksum;
+        }});
+        benchmarks.push_back({"get_knight_moves", sites[KNIGHT_WHITE - 1].size(), piece_moves(KNIGHT_WHITE, get_knight_moves)});
+        benchmarks.push_back({"get_bishop_moves", sites[BISHOP_WHITE - 1].size(), piece_moves(BISHOP_WHITE, get_bishop_moves)});
+        benchmarks.push_back({"get_rook_moves", sites[ROOK_WHITE - 1].size(), piece_moves(ROOK_WHITE, get_rook_moves)});
+        benchmarks.push_back({"get_queen_moves", sites[QUEEN_WHITE - 1].size(), piece_moves(QUEEN_WHITE, get_queen_moves)});
+        benchmarks.push_back({"get_king_moves", sites[KING_WHITE - 1].size(), piece_moves(KING_WHITE, get_king_moves)});
+
+        benchmarks.push_back({"is_in_check", boards.size(), [&boards]()
+        {
+            uint64_t checksum = 0;
+            for (const Board& board : boards)
+                checksum += board.is_in_check(board.get_turn());
+            return checksum;
+        }});
+        // Includes the unmake_move that restores the board for the next pass
+        benchmarks.push_back({"move_piece", game_moves.size(), [game_moves]()
+        {
+            uint64_t checksum = 0;
+            for (const GameMove& game_move : game_moves)
+            {
+                checksum += game_move.board->move_piece(game_move.from, game_move.to);
+                game_move.board->unmake_move();
+            }
+            return checksum;
+        }});
+        benchmarks.push_back({"board_to_string", boards.size(), [&boards]()
+        {
+            uint64_t checksum = 0;
+            for (const Board& board : boards)
+                checksum += board.board_to_string().size();
+            return checksum;
+        }});
+        benchmarks.push_back({"is_threefold_repetition", boards.size(), [&boards]()
+        {
+            uint64_t checksum = 0;
+            for (const Board& board : boards)
+                checksum += board.is_threefold_repetition();
+            return checksum;
+        }});
+        benchmarks.push_back({"is_checkmate", boards.size(), [&boards]()
+        {
+            uint64_t checksum = 0;
+            for (const Board& board : boards)
+                checksum += is_checkmate(board, board.get_turn());
+            return checksum;
+        }});
+        benchmarks.push_back({"is_insufficient_material", boards.size(), [&boards]()
+        {
+            uint64_t checksum = 0;
+            for (const Board& board : boards)
+                checksum += is_insufficient_material(board);
+            return checksum;
+        }});
+        return benchmarks;
+    }
+
+    double elapsed_ns(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    }
+
+    MicrobenchResult measure(const Benchmark& benchmark, int warmup, int repetitions)
+    {
+        MicrobenchResult result;
+        result.name = benchmark.name;
+        if (benchmark.calls == 0)
+            return result;
+
+        // Warmup also sizes the samples: enough passes to last MIN_SAMPLE_NS
+        auto start = Clock::now();
+        for (int i = 0; i < warmup; ++i)
+            sink = sink + benchmark.pass();
+        double pass_ns = warmup > 0 ? elapsed_ns(start) / warmup : MIN_SAMPLE_NS;
+        int passes = std::max(1, static_cast<int>(std::ceil(MIN_SAMPLE_NS / std::max(pass_ns, 1.0))));
+        result.calls_per_sample = benchmark.calls * passes;
+
+        std::vector<double> samples;
+        for (int i = 0; i < repetitions; ++i)
+        {
+            start = Clock::now();
+            for (int pass = 0; pass < passes; ++pass)
+                sink = sink + benchmark.pass();
+            samples.push_back(elapsed_ns(start) / result.calls_per_sample);
+        }
+
+        // Nearest-rank percentiles
+        std::sort(samples.begin(), samples.end());
+        auto percentile = [&samples](double q)
+        {
+            size_t rank = static_cast<size_t>(std::ceil(q * samples.size()));
+            return samples[std::min(samples.size(), std::max<size_t>(rank, 1)) - 1];
+        };
+        result.median_ns = percentile(0.50);
+        result.p99_ns = percentile(0.99);
+        result.min_ns = samples.front();
+        for (double sample : samples)
+            result.mean_ns += sample / samples.size();
+        return result;
+    }
+
+    void write_json(std::ostream& out, const std::vector<MicrobenchResult>& results, size_t corpus, int warmup, int repetitions)
+    {
+        out << "{\n  \"timestamp\": " << std::time(nullptr) << ",\n  \"corpus_positions\": " << corpus
+            << ",\n  \"warmup\": " << warmup << ",\n  \"repetitions\": " << repetitions << ",\n  \"benchmarks\": [";
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const MicrobenchResult& result = results[i];
+            out << (i ? "," : "") << "\n    {\"name\": \"" << result.name << "\", \"calls_per_sample\": " << result.calls_per_sample
+                << ", \"median_ns\": " << result.median_ns << ", \"p99_ns\": " << result.p99_ns
+                << ", \"min_ns\": " << result.min_ns << ", \"mean_ns\": " << result.mean_ns << "}";
+        }
+        out << "\n  ]\n}\n";
+    }
+}
+
+std::vector<MicrobenchResult> run_microbench(int warmup, int repetitions, const std::string& filter)
+{
+    std::vector<Board> boards = build_corpus();
+    std::vector<MicrobenchResult> results;
+    for (const Benchmark& benchmark : build_benchmarks(boards))
+    {
+        if (std::string(benchmark.name).find(filter) != std::string::npos)
+            results.push_back(measure(benchmark, warmup, std::max(1, repetitions)));
+    }
+    return results;
+}
+
+int microbench_command(const std::vector<std::string>& args)
+{
+    int warmup = 20;
+    int repetitions = 200;
+    std::string output;
+    std::string filter;
+    for (size_t i = 1; i < args.size(); ++i)
+    {
+        if (args[i] == "-w" && i + 1 < args.size())
+            warmup = std::max(0, std::atoi(args[++i].c_str()));
+        else if (args[i] == "-r" && i + 1 < args.size())
+            repetitions = std::max(1, std::atoi(args[++i].c_str()));
+        else if (args[i] == "-o" && i + 1 < args.size())
+            output = args[++i];
+        else
+            filter = args[i];
+    }
+
+    std::vector<MicrobenchResult> results = run_microbench(warmup, repetitions, filter);
+    size_t corpus = std::size(CORPUS_FENS) + RANDOM_POSITIONS;
+
+    std::cout << corpus << " positions, " << warmup << " warmup passes, " << repetitions << " samples\n"
+              << std::left << std::setw(26) << "primitive" << std::right << std::setw(10) << "calls"
+              << std::setw(12) << "median ns" << std::setw(12) << "p99 ns" << std::setw(12) << "min ns" << "\n";
+    for (const MicrobenchResult& result : results)
+    {
+        std::cout << std::left << std::setw(26) << result.name << std::right << std::setw(10) << result.calls_per_sample
+                  << std::fixed << std::setprecision(1) << std::setw(12) << result.median_ns << std::setw(12) << result.p99_ns
+                  << std::setw(12) << result.min_ns << "\n";
+    }
+
+    if (!output.empty())
+    {
+        std::ofstream file(output);
+        if (!file)
+        {
+            std::cerr << "Could not write " << output << "\n";
+            return 1;
+        }
+        write_json(file, results, corpus, warmup, repetitions);
+        std::cout << "Results written to " << output << "\n";
+    }
+    return 0;
+}
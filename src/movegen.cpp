@@ -0,0 +1,164 @@
+// movegen.cpp
+#include "movegen.hpp"
+#include "instrument.hpp"
+
+namespace
+{
+    // Appends a move to every target square, flagging captures
+    void add_moves(MoveList& moves, const Position& pos, int from, Bitboard targets)
+    {
+        while (targets)
+        {
+            int to = pop_lsb(targets);
+            moves.add(Move(from, to, pos.piece_on(to) != EMPTY ? MOVE_CAPTURE : MOVE_QUIET));
+        }
+    }
+
+    // Adds a pawn move, expanded into the four promotions on the last rank
+    template<int Us>
+    void add_pawn_move(MoveList& moves, int from, int to, int flags)
+    {
+        if (square_bb(to) & Side<Us>::promotion_rank)
+        {
+            for (int type = QUEEN_WHITE; type >= KNIGHT_WHITE; --type)
+                moves.add(Move(from, to, flags | MOVE_PROMOTION | (type - KNIGHT_WHITE)));
+        }
+        else
+            moves.add(Move(from, to, flags));
+    }
+
+    // Own pieces that are the only blocker between the king and an enemy slider
+    template<int Us>
+    Bitboard pinned_pieces(const Position& pos, int king)
+    {
+        typedef Side<Side<Us>::them> Them;
+        Bitboard queens = pos.pieces_of(Them::queen);
+        Bitboard snipers = (rook_attacks(king, 0) & (pos.pieces_of(Them::rook) | queens))
+                         | (bishop_attacks(king, 0) & (pos.pieces_of(Them::bishop) | queens));
+
+        Bitboard pinned = 0;
+        while (snipers)
+        {
+            Bitboard blockers = between_bb(king, pop_lsb(snipers)) & pos.occupied;
+            if (blockers && !(blockers & (blockers - 1)))
+                pinned |= blockers & pos.occupancy[Us];
+        }
+        return pinned;
+    }
+
+    template<int Us>
+    void add_pawn_moves(MoveList& moves, const Position& pos, int from, int king, Bitboard allowed)
+    {
+        typedef Side<Us> S;
+        int forward = from + S::push;
+
+        // Pushes
+        if (pos.piece_on(forward) == EMPTY)
+        {
+            if (allowed & square_bb(forward))
+                add_pawn_move<Us>(moves, from, forward, MOVE_QUIET);
+
+            int double_push = forward + S::push;
+            if (square_rank(from) == S::start_rank && pos.piece_on(double_push) == EMPTY &&
+                (allowed & square_bb(double_push)))
+                moves.add(Move(from, double_push, MOVE_DOUBLE_PUSH));
+        }
+
+        // Captures
+        Bitboard attacks = pawn_attacks(Us, from);
+        Bitboard captures = attacks & pos.occupancy[S::them] & allowed;
+        while (captures)
+            add_pawn_move<Us>(moves, from, pop_lsb(captures), MOVE_CAPTURE);
+
+        // En passant removes two pawns from the board at once, so it is
+        // checked on the resulting occupancy (this covers discovered checks)
+        if (pos.en_passant != NO_SQUARE && (attacks & square_bb(pos.en_passant)))
+        {
+            int captured = pos.en_passant - S::push;
+            Bitboard occupied = (pos.occupied ^ square_bb(from) ^ square_bb(captured)) | square_bb(pos.en_passant);
+            Bitboard checkers = attackers_to(pos, king, occupied) & pos.occupancy[S::them] & ~square_bb(captured);
+            if (!checkers)
+                moves.add(Move(from, pos.en_passant, MOVE_EN_PASSANT));
+        }
+    }
+
+    template<int Us>
+    void generate_legal(const Position& pos, MoveList& moves)
+    {
+        typedef Side<Us> S;
+        int king = lsb(pos.pieces_of(S::king));
+
+        Bitboard own = pos.occupancy[Us];
+        Bitboard enemy = pos.occupancy[S::them];
+        Bitboard checkers = attackers_to(pos, king, pos.occupied) & enemy;
+
+        // King moves: the target must stay safe once the king has left its square
+        Bitboard without_king = pos.occupied ^ square_bb(king);
+        Bitboard targets = king_attacks(king) & ~own;
+        while (targets)
+        {
+            int to = pop_lsb(targets);
+            if (!attacked_by<S::them>(pos, to, without_king))
+                moves.add(Move(king, to, pos.piece_on(to) != EMPTY ? MOVE_CAPTURE : MOVE_QUIET));
+        }
+
+        // In double check only the king can move
+        if (checkers & (checkers - 1))
+            return;
+
+        // With a single checker, other pieces must capture it or block the line
+        Bitboard evasion = ~Bitboard(0);
+        if (checkers)
+            evasion = checkers | between_bb(king, lsb(checkers));
+        else
+        {
+            // castling_allowed also rejects castling through an attacked square
+            if (castling_allowed<Us, true>(pos))
+                moves.add(Move(king, king + 2, MOVE_KING_CASTLE));
+            if (castling_allowed<Us, false>(pos))
+                moves.add(Move(king, king - 2, MOVE_QUEEN_CASTLE));
+        }
+
+        Bitboard pinned = pinned_pieces<Us>(pos, king);
+        Bitboard pieces = own & ~square_bb(king);
+        while (pieces)
+        {
+            int from = pop_lsb(pieces);
+            Bitboard allowed = evasion;
+            if (pinned & square_bb(from))
+                allowed &= line_bb(king, from); // Pinned pieces stay on the pin line
+
+            switch (piece_type(pos.piece_on(from)))
+            {
+                case PAWN_WHITE:
+                    add_pawn_moves<Us>(moves, pos, from, king, allowed);
+                    break;
+                case KNIGHT_WHITE:
+                    add_moves(moves, pos, from, knight_attacks(from) & ~own & allowed);
+                    break;
+                case BISHOP_WHITE:
+                    add_moves(moves, pos, from, bishop_attacks(from, pos.occupied) & ~own & allowed);
+                    break;
+                case ROOK_WHITE:
+                    add_moves(moves, pos, from, rook_attacks(from, pos.occupied) & ~own & allowed);
+                    break;
+                case QUEEN_WHITE:
+                    add_moves(moves, pos, from, queen_attacks(from, pos.occupied) & ~own & allowed);
+                    break;
+            }
+        }
+    }
+}
+
+void generate_legal_moves(const Board& board, MoveList& moves)
+{
+    INSTRUMENT_SCOPE(Probe::GenerateLegalMoves);
+    const Position& pos = board.get_position();
+    if (pos.king_square(pos.turn) == NO_SQUARE)
+        return;
+
+    if (pos.turn == 1)
+        generate_legal<WHITE>(pos, moves);
+    else
+        generate_legal<BLACK>(pos, moves);
+}
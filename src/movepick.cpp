@@ -0,0 +1,195 @@
+// movepick.cpp
+#include "movepick.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include "movegen.hpp"
+
+namespace
+{
+    // History moves towards the bonus, bounded by MAX_HISTORY
+    void apply_bonus(int& entry, int bonus)
+    {
+        entry += bonus - entry * std::abs(bonus) / MAX_HISTORY;
+    }
+
+    bool is_tactical(Move move)
+    {
+        return move.is_capture() || move.is_promotion();
+    }
+
+    // A capture of an equal or bigger piece never loses material; the rest need SEE
+    bool is_good_capture(const Position& pos, Move move)
+    {
+        int attacker = SEE_VALUES[piece_type(pos.piece_on(move.from()))];
+        int victim = move.flags() == MOVE_EN_PASSANT ? SEE_VALUES[PAWN_WHITE] : SEE_VALUES[piece_type(pos.piece_on(move.to()))];
+        return victim >= attacker || see(pos, move) >= 0;
+    }
+
+    // Piece that made the previous move, found on its destination square
+    int moved_piece(const Position& pos, Move previous)
+    {
+        return previous == NULL_MOVE ? EMPTY : pos.piece_on(previous.to());
+    }
+}
+
+void HistoryTables::clear()
+{
+    std::memset(this, 0, sizeof(*this));
+}
+
+void HistoryTables::update(const Position& pos, Move best, const Move* tried, int tried_count, int depth, int ply, Move previous)
+{
+    int bonus = std::min(depth * depth, 400);
+    int color = color_index(pos.turn);
+    apply_bonus(butterfly[color][best.from()][best.to()], bonus);
+    for (int i = 0; i < tried_count; ++i)
+    {
+        if (tried[i] != best)
+            apply_bonus(butterfly[color][tried[i].from()][tried[i].to()], -bonus);
+    }
+
+    if (killers[ply][0] != best)
+    {
+        killers[ply][1] = killers[ply][0];
+        killers[ply][0] = best;
+    }
+
+    int piece = moved_piece(pos, previous);
+    if (piece != EMPTY)
+        countermoves[piece_index(piece)][previous.to()] = best;
+}
+
+MovePicker::MovePicker(const Board& board, const HistoryTables& history, Move tt_move, int ply, Move previous,
+                       bool tactical_only)
+    : pos(board.get_position()), history(history), tt_move(tt_move), tactical_only(tactical_only)
+{
+    generate_legal_moves(board, moves);
+
+    int piece = moved_piece(pos, previous);
+    special[0] = history.killers[ply][0];
+    special[1] = history.killers[ply][1];
+    special[2] = piece != EMPTY ? history.countermoves[piece_index(piece)][previous.to()] : NULL_MOVE;
+}
+
+// Moves the best scored move of [current, end) to current and returns it
+Move MovePicker::pick_best()
+{
+    int best = current;
+    for (int i = current + 1; i < end; ++i)
+    {
+        if (scores[i] > scores[best])
+            best = i;
+    }
+    std::swap(moves.moves[current], moves.moves[best]);
+    std::swap(scores[current], scores[best]);
+    return moves.moves[current++];
+}
+
+bool MovePicker::is_special(Move move) const
+{
+    return move == special[0] || move == special[1] || move == special[2];
+}
+
+bool MovePicker::is_quiet_in_list(Move move) const
+{
+    for (int i = capture_end; i < moves.size(); ++i)
+    {
+        if (moves.moves[i] == move)
+            return true;
+    }
+    return false;
+}
+
+Move MovePicker::next()
+{
+    switch (stage)
+    {
+        case TT_MOVE:
+            stage = INIT_CAPTURES;
+            if (tt_move != NULL_MOVE && moves.contains(tt_move))
+                return tt_move;
+            tt_move = NULL_MOVE;
+            [[fallthrough]];
+
+        case INIT_CAPTURES:
+        {
+            // Captures and promotions go to the front of the list
+            capture_end = std::partition(moves.begin(), moves.end(), is_tactical) - moves.begin();
+            for (int i = 0; i < capture_end; ++i)
+            {
+                Move move = moves.moves[i];
+                int victim = move.flags() == MOVE_EN_PASSANT ? PAWN_WHITE : piece_type(pos.piece_on(move.to()));
+                int attacker = piece_type(pos.piece_on(move.from()));
+                scores[i] = victim * 8 - attacker + (move.is_promotion() ? move.promotion_type() * 8 : 0);
+            }
+            current = 0;
+            end = capture_end;
+            stage = CAPTURES;
+            [[fallthrough]];
+        }
+
+        case CAPTURES:
+            while (current < end)
+            {
+                Move move = pick_best();
+                if (move == tt_move)
+                    continue;
+                if (!is_good_capture(pos, move))
+                    bad_captures[bad_count++] = move;
+                else
+                    return move;
+            }
+            if (tactical_only)
+            {
+                stage = DONE;
+                return NULL_MOVE;
+            }
+            stage = SPECIAL_QUIETS;
+            [[fallthrough]];
+
+        case SPECIAL_QUIETS:
+            while (special_index < 3)
+            {
+                Move move = special[special_index++];
+                bool repeated = false;
+                for (int i = 0; i < special_index - 1; ++i)
+                    repeated |= special[i] == move;
+                if (move != NULL_MOVE && move != tt_move && !repeated && is_quiet_in_list(move))
+                    return move;
+            }
+            stage = INIT_QUIETS;
+            [[fallthrough]];
+
+        case INIT_QUIETS:
+        {
+            int color = color_index(pos.turn);
+            for (int i = capture_end; i < moves.size(); ++i)
+                scores[i] = history.butterfly[color][moves.moves[i].from()][moves.moves[i].to()];
+            current = capture_end;
+            end = moves.size();
+            stage = QUIETS;
+            [[fallthrough]];
+        }
+
+        case QUIETS:
+            while (current < end)
+            {
+                Move move = pick_best();
+                if (move != tt_move && !is_special(move))
+                    return move;
+            }
+            stage = BAD_CAPTURES;
+            [[fallthrough]];
+
+        case BAD_CAPTURES:
+            if (bad_index < bad_count)
+                return bad_captures[bad_index++];
+            stage = DONE;
+            [[fallthrough]];
+
+        case DONE:
+            break;
+    }
+    return NULL_MOVE;
+}
@@ -1,5 +1,6 @@
 // moves.cpp
 #include "moves.hpp"
+#include <algorithm>
 
 std::pair<int, int> chess_to_index(const std::string& position)
 {
@@ -15,164 +16,322 @@ std::string index_to_chess(int row, int col)
     return std::string{col_char, row_char};
 }
 
-// Pawn moves and captures
-std::vector<std::pair<int, int>> get_pawn_moves(int x, int y,
-    const std::vector<std::vector<int>>& board, bool is_white)
+// Works out the flags of a from/to pair from the pieces on the board
+Move encode_move(const Position& pos, int from, int to, int promotion_type)
 {
-    std::vector<std::pair<int, int>> moves;
-    int direction = is_white ? 1 : -1;
+    int piece = piece_type(pos.piece_on(from));
+    int flags = pos.piece_on(to) != EMPTY ? MOVE_CAPTURE : MOVE_QUIET;
 
-    // Ensure x is within board bounds before checking moves
-    if (x < 0 || x >= 8 || y < 0 || y >= 8)
-        return moves; // Return an empty moves list if out of bounds
-
-    // Forward move by one square, with boundary check
-    if (x + direction >= 0 && x + direction < 8 && board[x + direction][y] == EMPTY)
+    if (piece == PAWN_WHITE)
     {
-        moves.emplace_back(x + direction, y);
-
-        // Initial double move for pawns in their starting rank
-        if ((is_white && x == 1) || (!is_white && x == 6))
-        {
-            if (board[x + 2 * direction][y] == EMPTY)
-                moves.emplace_back(x + 2 * direction, y);
-        }
+        if (to == pos.en_passant)
+            flags = MOVE_EN_PASSANT;
+        else if (to - from == 16 || from - to == 16)
+            flags = MOVE_DOUBLE_PUSH;
+        else if (square_bb(to) & (RANK_1 | RANK_8))
+            flags |= MOVE_PROMOTION | (promotion_type - KNIGHT_WHITE);
     }
+    else if (piece == KING_WHITE && (to - from == 2 || from - to == 2))
+        flags = to > from ? MOVE_KING_CASTLE : MOVE_QUEEN_CASTLE;
+
+    return Move(from, to, flags);
+}
+
+// Coordinate notation, e.g. "e2e4" or "e7e8q"
+std::string move_to_string(Move move)
+{
+    std::string text = index_to_chess(square_row(move.from()), square_col(move.from())) +
+                       index_to_chess(square_row(move.to()), square_col(move.to()));
+    std::transform(text.begin(), text.end(), text.begin(), ::tolower);
+    if (move.is_promotion())
+        text += "nbrq"[move.promotion_type() - KNIGHT_WHITE];
+    return text;
+}
 
-    // Diagonal captures with boundary checks
-    if (x + direction >= 0 && x + direction < 8)
+// Appends a move to every target square, flagging captures
+static void append_targets(MoveList& moves, const Position& pos, int from, Bitboard targets)
+{
+    while (targets)
     {
-        // Left diagonal capture
-        if (y - 1 >= 0 && board[x + direction][y - 1] * (is_white ? -1 : 1) < 0)
-            moves.emplace_back(x + direction, y - 1);
-        // Right diagonal capture
-        if (y + 1 < 8 && board[x + direction][y + 1] * (is_white ? -1 : 1) < 0)
-            moves.emplace_back(x + direction, y + 1);
+        int to = pop_lsb(targets);
+        moves.add(Move(from, to, pos.piece_on(to) != EMPTY ? MOVE_CAPTURE : MOVE_QUIET));
     }
+}
 
-    return moves;
+// Squares the piece standing on the square may not land on (its own side)
+static Bitboard own_pieces(int square, const Position& pos)
+{
+    int piece = pos.piece_on(square);
+    return piece == EMPTY ? 0 : pos.color_pieces(piece);
 }
 
-// Knight moves
-std::vector<std::pair<int, int>> get_knight_moves(int x, int y,
-    const std::vector<std::vector<int>>& board)
+// Adds a pawn move, expanded into the four promotions on the last rank
+static void append_pawn_move(MoveList& moves, int from, int to, int flags)
+{
+    if (square_bb(to) & (RANK_1 | RANK_8))
     {
-    std::vector<std::pair<int, int>> moves;
-    std::vector<std::pair<int, int>> knight_offsets =
-    { {2, 1}, {2, -1}, {-2, 1}, {-2, -1}, {1, 2}, {1, -2}, {-1, 2}, {-1, -2} };
+        for (int type = QUEEN_WHITE; type >= KNIGHT_WHITE; --type)
+            moves.add(Move(from, to, flags | MOVE_PROMOTION | (type - KNIGHT_WHITE)));
+    }
+    else
+        moves.add(Move(from, to, flags));
+}
+
+// Pawn moves and captures, for a pawn of side Us
+template<int Us>
+static void append_pawn_moves(int square, const Position& pos, MoveList& moves)
+{
+    typedef Side<Us> S;
 
-    for (const auto& offset : knight_offsets)
+    // A pawn on its last rank has nowhere to go
+    if (square_bb(square) & S::promotion_rank)
+        return;
+    int forward = square + S::push;
+
+    // Forward move by one square
+    if (pos.piece_on(forward) == EMPTY)
     {
-        int nx = x + offset.first;
-        int ny = y + offset.second;
-        if (nx >= 0 && nx < 8 && ny >= 0 && ny < 8 &&
-            board[nx][ny] * board[x][y] <= 0)
-            moves.emplace_back(nx, ny);
+        append_pawn_move(moves, square, forward, MOVE_QUIET);
+
+        // Initial double move for pawns in their starting rank
+        if (square_rank(square) == S::start_rank && pos.piece_on(forward + S::push) == EMPTY)
+            moves.add(Move(square, forward + S::push, MOVE_DOUBLE_PUSH));
     }
-    return moves;
+
+    // Diagonal captures, including en passant
+    Bitboard attacks = pawn_attacks(Us, square);
+    Bitboard captures = attacks & pos.occupancy[S::them];
+    while (captures)
+        append_pawn_move(moves, square, pop_lsb(captures), MOVE_CAPTURE);
+
+    if (pos.en_passant != NO_SQUARE && pos.turn == S::player && (attacks & square_bb(pos.en_passant)))
+        moves.add(Move(square, pos.en_passant, MOVE_EN_PASSANT));
+}
+
+void get_pawn_moves(int x, int y, const Position& pos, bool is_white, MoveList& moves)
+{
+    // Ensure x is within board bounds before checking moves
+    if (x < 0 || x >= 8 || y < 0 || y >= 8)
+        return;
+
+    if (is_white)
+        append_pawn_moves<WHITE>(make_square(x, y), pos, moves);
+    else
+        append_pawn_moves<BLACK>(make_square(x, y), pos, moves);
+}
+
+// Knight moves
+void get_knight_moves(int x, int y, const Position& pos, MoveList& moves)
+{
+    int square = make_square(x, y);
+    append_targets(moves, pos, square, knight_attacks(square) & ~own_pieces(square, pos));
 }
 
 // Bishop movements (diagonal)
-std::vector<std::pair<int, int>> get_bishop_moves(int x, int y,
-	const std::vector<std::vector<int>>& board)
-{
-    std::vector<std::pair<int, int>> moves;
-    std::vector<std::pair<int, int>> directions =
-        { {1, 1}, {1, -1}, {-1, 1}, {-1, -1} };
-
-    for (const auto& dir : directions)
-	{
-        int nx = x + dir.first;
-        int ny = y + dir.second;
-        while (nx >= 0 && nx < 8 && ny >= 0 && ny < 8)
-		{
-            if (board[nx][ny] == EMPTY)
-                moves.emplace_back(nx, ny);
-            else
-			{
-                if (board[nx][ny] * board[x][y] < 0)
-                    moves.emplace_back(nx, ny);  // Capture
-                break;
-            }
-            nx += dir.first;
-            ny += dir.second;
-        }
-    }
-    return moves;
+void get_bishop_moves(int x, int y, const Position& pos, MoveList& moves)
+{
+    int square = make_square(x, y);
+    append_targets(moves, pos, square, bishop_attacks(square, pos.occupied) & ~own_pieces(square, pos));
 }
 
 // Rook movements (horizontal & vertical)
-std::vector<std::pair<int, int>> get_rook_moves(int x, int y,
-	const std::vector<std::vector<int>>& board)
-	{
-    std::vector<std::pair<int, int>> moves;
-    std::vector<std::pair<int, int>> directions = { {1, 0}, {-1, 0}, {0, 1}, {0, -1} };
-
-    for (const auto& dir : directions)
-	{
-        int nx = x + dir.first;
-        int ny = y + dir.second;
-        while (nx >= 0 && nx < 8 && ny >= 0 && ny < 8) {
-            if (board[nx][ny] == EMPTY)
-                moves.emplace_back(nx, ny);
-			else
-			{
-                if (board[nx][ny] * board[x][y] < 0)
-                    moves.emplace_back(nx, ny);  // Capture
+void get_rook_moves(int x, int y, const Position& pos, MoveList& moves)
+{
+    int square = make_square(x, y);
+    append_targets(moves, pos, square, rook_attacks(square, pos.occupied) & ~own_pieces(square, pos));
+}
+
+// Queen moves (combination of rook and bishop moves)
+void get_queen_moves(int x, int y, const Position& pos, MoveList& moves)
+{
+    int square = make_square(x, y);
+    append_targets(moves, pos, square, queen_attacks(square, pos.occupied) & ~own_pieces(square, pos));
+}
+
+// King moves, including castling when the rights and path allow it
+void get_king_moves(int x, int y, const Position& pos, MoveList& moves)
+{
+    int square = make_square(x, y);
+    append_targets(moves, pos, square, king_attacks(square) & ~own_pieces(square, pos));
+
+    // castling_allowed checks the king stands on its start square
+    int player = pos.piece_on(square) > 0 ? 1 : -1;
+    if (castling_allowed(pos, player, true))
+        moves.add(Move(square, square + 2, MOVE_KING_CASTLE));
+    if (castling_allowed(pos, player, false))
+        moves.add(Move(square, square - 2, MOVE_QUEEN_CASTLE));
+}
+
+// Pieces of both colors attacking the square, with sliders seen through the given occupancy
+Bitboard attackers_to(const Position& pos, int square, Bitboard occupied)
+{
+    Bitboard queens = pos.pieces_of(QUEEN_WHITE) | pos.pieces_of(QUEEN_BLACK);
+    Bitboard bishops = pos.pieces_of(BISHOP_WHITE) | pos.pieces_of(BISHOP_BLACK) | queens;
+    Bitboard rooks = pos.pieces_of(ROOK_WHITE) | pos.pieces_of(ROOK_BLACK) | queens;
+
+    return (pawn_attacks(BLACK, square) & pos.pieces_of(PAWN_WHITE))
+         | (pawn_attacks(WHITE, square) & pos.pieces_of(PAWN_BLACK))
+         | (knight_attacks(square) & (pos.pieces_of(KNIGHT_WHITE) | pos.pieces_of(KNIGHT_BLACK)))
+         | (king_attacks(square) & (pos.pieces_of(KING_WHITE) | pos.pieces_of(KING_BLACK)))
+         | (bishop_attacks(square, occupied) & bishops)
+         | (rook_attacks(square, occupied) & rooks);
+}
+
+// Looks outward from the square for a piece of side Us that attacks it:
+// pawn diagonals, knight and king patterns, then sliding rays up to the first blocker
+template<int Us>
+bool attacked_by(const Position& pos, int square, Bitboard occupied)
+{
+    typedef Side<Us> S;
+
+    if (pawn_attacks(S::them, square) & pos.pieces_of(S::pawn))
+        return true;
+    if (knight_attacks(square) & pos.pieces_of(S::knight))
+        return true;
+    if (king_attacks(square) & pos.pieces_of(S::king))
+        return true;
+
+    Bitboard queens = pos.pieces_of(S::queen);
+    Bitboard diagonal = pos.pieces_of(S::bishop) | queens;
+    if (diagonal && (bishop_attacks(square, occupied) & diagonal))
+        return true;
+    Bitboard straight = pos.pieces_of(S::rook) | queens;
+    return straight && (rook_attacks(square, occupied) & straight);
+}
+
+template bool attacked_by<WHITE>(const Position& pos, int square, Bitboard occupied);
+template bool attacked_by<BLACK>(const Position& pos, int square, Bitboard occupied);
+
+bool is_square_attacked(const Position& pos, int square, int by_player)
+{
+    return by_player > 0 ? attacked_by<WHITE>(pos, square, pos.occupied)
+                         : attacked_by<BLACK>(pos, square, pos.occupied);
+}
+
+// Castling needs the right, an empty path and a king that does not cross an attacked square
+template<int Us, bool Kingside>
+bool castling_allowed(const Position& pos)
+{
+    typedef Side<Us> S;
+    constexpr int right = Kingside ? S::castle_kingside : S::castle_queenside;
+    constexpr int king_from = S::king_start;
+    constexpr int rook_from = Kingside ? king_from + 3 : king_from - 4;
+    constexpr int step = Kingside ? 1 : -1;
+    constexpr Bitboard path = Kingside ? square_bb(king_from + 1) | square_bb(king_from + 2)
+                                       : square_bb(king_from - 1) | square_bb(king_from - 2) | square_bb(king_from - 3);
+
+    if (!(pos.castling & right) || (pos.occupied & path))
+        return false;
+    if (pos.piece_on(king_from) != S::king || pos.piece_on(rook_from) != S::rook)
+        return false;
+
+    for (int i = 0; i <= 2; ++i)
+    {
+        if (attacked_by<S::them>(pos, king_from + i * step, pos.occupied))
+            return false;
+    }
+    return true;
+}
+
+template bool castling_allowed<WHITE, true>(const Position& pos);
+template bool castling_allowed<WHITE, false>(const Position& pos);
+template bool castling_allowed<BLACK, true>(const Position& pos);
+template bool castling_allowed<BLACK, false>(const Position& pos);
+
+bool castling_allowed(const Position& pos, int player, bool is_kingside)
+{
+    if (player > 0)
+        return is_kingside ? castling_allowed<WHITE, true>(pos) : castling_allowed<WHITE, false>(pos);
+    return is_kingside ? castling_allowed<BLACK, true>(pos) : castling_allowed<BLACK, false>(pos);
+}
+
+// Swap-list exchange on the destination square: each side recaptures with its
+// least valuable attacker and may stop whenever going on would lose material.
+// Sliders behind a capturer join in as the occupancy is thinned out.
+int see(const Position& pos, Move move)
+{
+    if (move.is_castle())
+        return 0;
+
+    int from = move.from();
+    int to = move.to();
+    int gain[32];
+    int depth = 0;
+    gain[0] = move.flags() == MOVE_EN_PASSANT ? SEE_VALUES[PAWN_WHITE] : SEE_VALUES[piece_type(pos.piece_on(to))];
+    int on_square = piece_type(pos.piece_on(from));
+    if (move.is_promotion())
+    {
+        gain[0] += SEE_VALUES[move.promotion_type()] - SEE_VALUES[PAWN_WHITE];
+        on_square = move.promotion_type();
+    }
+
+    Bitboard occupied = pos.occupied ^ square_bb(from);
+    if (move.flags() == MOVE_EN_PASSANT)
+        occupied ^= square_bb(to - 8 * pos.turn);
+
+    int side = -pos.turn;
+    while (depth < 31)
+    {
+        Bitboard attackers = attackers_to(pos, to, occupied) & occupied & pos.color_pieces(side);
+        if (!attackers)
+            break;
+
+        ++depth;
+        gain[depth] = SEE_VALUES[on_square] - gain[depth - 1];
+        // Stopping here or going on both lose, the outcome's sign is settled
+        if (std::max(-gain[depth - 1], gain[depth]) < 0)
+        {
+            --depth;
+            break;
+        }
+
+        for (int type = PAWN_WHITE; type <= KING_WHITE; ++type)
+        {
+            Bitboard candidates = attackers & pos.pieces_of(type * side);
+            if (candidates)
+            {
+                occupied ^= square_bb(lsb(candidates));
+                on_square = type;
                 break;
             }
-            nx += dir.first;
-            ny += dir.second;
         }
+        side = -side;
     }
-    return moves;
-}
 
-// Queen moves (combination of rook and bishop moves)
-std::vector<std::pair<int, int>> get_queen_moves(int x, int y,
-	const std::vector<std::vector<int>>& board)
-{
-    auto rook_moves = get_rook_moves(x, y, board);
-    auto bishop_moves = get_bishop_moves(x, y, board);
-    rook_moves.insert(rook_moves.end(), bishop_moves.begin(), bishop_moves.end());
-    return rook_moves;
-}
-
-// King moves
-std::vector<std::pair<int, int>> get_king_moves(int x, int y,
-	const std::vector<std::vector<int>>& board)
-	{
-    std::vector<std::pair<int, int>> moves;
-    std::vector<std::pair<int, int>> directions =
-	{ {1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {-1, -1}, {1, -1}, {-1, 1} };
-
-    for (const auto& dir : directions)
-	{
-        int nx = x + dir.first;
-        int ny = y + dir.second;
-        if (nx >= 0 && nx < 8 && ny >= 0 && ny < 8 && board[nx][ny] * board[x][y] <= 0)
-            moves.emplace_back(nx, ny);
+    while (depth > 0)
+    {
+        gain[depth - 1] = -std::max(-gain[depth - 1], gain[depth]);
+        --depth;
     }
-    return moves;
+    return gain[0];
 }
 
-std::vector<std::pair<int, int>> get_moves(int x, int y, const std::vector<std::vector<int>>& board)
+void get_moves(int x, int y, const Position& pos, MoveList& moves)
 {
-    int piece = board[x][y];
+    int piece = pos.piece_on(make_square(x, y));
     if (piece == PAWN_WHITE) {
-        return get_pawn_moves(x, y, board, true);
+        get_pawn_moves(x, y, pos, true, moves);
     } else if (piece == PAWN_BLACK) {
-        return get_pawn_moves(x, y, board, false);
+        get_pawn_moves(x, y, pos, false, moves);
     } else if (piece == KNIGHT_WHITE || piece == KNIGHT_BLACK) {
-        return get_knight_moves(x, y, board);
+        get_knight_moves(x, y, pos, moves);
     } else if (piece == BISHOP_WHITE || piece == BISHOP_BLACK) {
-        return get_bishop_moves(x, y, board);
+        get_bishop_moves(x, y, pos, moves);
     } else if (piece == ROOK_WHITE || piece == ROOK_BLACK) {
-        return get_rook_moves(x, y, board);
+        get_rook_moves(x, y, pos, moves);
     } else if (piece == QUEEN_WHITE || piece == QUEEN_BLACK) {
-        return get_queen_moves(x, y, board);
+        get_queen_moves(x, y, pos, moves);
     } else if (piece == KING_WHITE || piece == KING_BLACK) {
-        return get_king_moves(x, y, board);
+        get_king_moves(x, y, pos, moves);
+    }
+}
+
+void generate_moves(const Position& pos, MoveList& moves)
+{
+    Bitboard pieces = pos.color_pieces(pos.turn);
+    while (pieces)
+    {
+        int square = pop_lsb(pieces);
+        get_moves(square_row(square), square_col(square), pos, moves);
     }
-    return {};
 }
@@ -0,0 +1,532 @@
+// nnue.cpp
+#include "nnue.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include "ai.hpp"
+#include "board.hpp"
+#include "movegen.hpp"
+#include "search.hpp"
+#include "tt.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define NNUE_X86 1
+#endif
+
+// Weights file layout, little endian:
+//   char magic[4] = "NNUE", uint32 version = 1, uint32 hidden size = 256
+//   int16 feature_weights[768][256], int16 feature_bias[256]
+//   int8  l2_weights[32][512],       int32 l2_bias[32]
+//   int8  l3_weights[32][32],        int32 l3_bias[32]
+//   int8  out_weights[32],           int32 out_bias
+// Feature index is piece_index * 64 + square, seen from each side with black's
+// view mirrored. Activations are clamped to 0..127, dense sums are shifted
+// right by 6 before clamping, and the output divided by 16 is in centipawns.
+
+namespace
+{
+    constexpr uint32_t FILE_VERSION = 1;
+    constexpr int DENSE_SHIFT = 6;
+    constexpr int OUTPUT_DIVISOR = 16;
+
+    struct Network
+    {
+        alignas(64) int16_t feature_weights[NNUE_INPUTS][NNUE_HIDDEN];
+        alignas(64) int16_t feature_bias[NNUE_HIDDEN];
+        alignas(64) int8_t l2_weights[NNUE_L2][2 * NNUE_HIDDEN];
+        alignas(64) int32_t l2_bias[NNUE_L2];
+        alignas(64) int8_t l3_weights[NNUE_L3][NNUE_L2];
+        alignas(64) int32_t l3_bias[NNUE_L3];
+        alignas(64) int8_t out_weights[NNUE_L3];
+        int32_t out_bias;
+    };
+
+    std::unique_ptr<Network> network;
+    bool enabled = true;
+
+    // Scalar kernels, used when the CPU has no suitable SIMD extension
+    void add_row_scalar(int16_t* accumulator, const int16_t* row)
+    {
+        for (int i = 0; i < NNUE_HIDDEN; ++i)
+            accumulator[i] += row[i];
+    }
+
+    void sub_row_scalar(int16_t* accumulator, const int16_t* row)
+    {
+        for (int i = 0; i < NNUE_HIDDEN; ++i)
+            accumulator[i] -= row[i];
+    }
+
+    void clamp_scalar(const int16_t* input, uint8_t* output, int count)
+    {
+        for (int i = 0; i < count; ++i)
+            output[i] = static_cast<uint8_t>(std::clamp<int>(input[i], 0, 127));
+    }
+
+    int32_t dot_scalar(const uint8_t* input, const int8_t* weights, int count)
+    {
+        int32_t sum = 0;
+        for (int i = 0; i < count; ++i)
+            sum += input[i] * weights[i];
+        return sum;
+    }
+
+#ifdef NNUE_X86
+    __attribute__((target("ssse3"))) void add_row_ssse3(int16_t* accumulator, const int16_t* row)
+    {
+        for (int i = 0; i < NNUE_HIDDEN; i += 8)
+        {
+            __m128i* target = reinterpret_cast<__m128i*>(accumulator + i);
+            *target = _mm_add_epi16(*target, _mm_load_si128(reinterpret_cast<const __m128i*>(row + i)));
+        }
+    }
+
+    __attribute__((target("ssse3"))) void sub_row_ssse3(int16_t* accumulator, const int16_t* row)
+    {
+        for (int i = 0; i < NNUE_HIDDEN; i += 8)
+        {
+            __m128i* target = reinterpret_cast<__m128i*>(accumulator + i);
+            *target = _mm_sub_epi16(*target, _mm_load_si128(reinterpret_cast<const __m128i*>(row + i)));
+        }
+    }
+
+    __attribute__((target("ssse3"))) void clamp_ssse3(const int16_t* input, uint8_t* output, int count)
+    {
+        const __m128i limit = _mm_set1_epi8(127);
+        for (int i = 0; i < count; i += 16)
+        {
+            __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+            __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i + 8));
+            __m128i packed = _mm_min_epu8(_mm_packus_epi16(low, high), limit);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), packed);
+        }
+    }
+
+    __attribute__((target("ssse3"))) int32_t dot_ssse3(const uint8_t* input, const int8_t* weights, int count)
+    {
+        const __m128i ones = _mm_set1_epi16(1);
+        __m128i sum = _mm_setzero_si128();
+        for (int i = 0; i < count; i += 16)
+        {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+            __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i));
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_maddubs_epi16(x, w), ones));
+        }
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+        return _mm_cvtsi128_si32(sum);
+    }
+
+    __attribute__((target("avx2"))) void add_row_avx2(int16_t* accumulator, const int16_t* row)
+    {
+        for (int i = 0; i < NNUE_HIDDEN; i += 16)
+        {
+            __m256i* target = reinterpret_cast<__m256i*>(accumulator + i);
+            *target = _mm256_add_epi16(*target, _mm256_load_si256(reinterpret_cast<const __m256i*>(row + i)));
+        }
+    }
+
+    __attribute__((target("avx2"))) void sub_row_avx2(int16_t* accumulator, const int16_t* row)
+    {
+        for (int i = 0; i < NNUE_HIDDEN; i += 16)
+        {
+            __m256i* target = reinterpret_cast<__m256i*>(accumulator + i);
+            *target = _mm256_sub_epi16(*target, _mm256_load_si256(reinterpret_cast<const __m256i*>(row + i)));
+        }
+    }
+
+    __attribute__((target("avx2"))) void clamp_avx2(const int16_t* input, uint8_t* output, int count)
+    {
+        const __m256i limit = _mm256_set1_epi8(127);
+        for (int i = 0; i < count; i += 32)
+        {
+            __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i));
+            __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i + 16));
+            // packus works per 128-bit lane, the permute restores the input order
+            __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), 0xD8);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), _mm256_min_epu8(packed, limit));
+        }
+    }
+
+    __attribute__((target("avx2"))) int32_t dot_avx2(const uint8_t* input, const int8_t* weights, int count)
+    {
+        const __m256i ones = _mm256_set1_epi16(1);
+        __m256i sum = _mm256_setzero_si256();
+        for (int i = 0; i < count; i += 32)
+        {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i));
+            __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i));
+            sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_maddubs_epi16(x, w), ones));
+        }
+        __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+        half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+        half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+        return _mm_cvtsi128_si32(half);
+    }
+#endif
+
+    struct Kernels
+    {
+        const char* name;
+        void (*add_row)(int16_t* accumulator, const int16_t* row);
+        void (*sub_row)(int16_t* accumulator, const int16_t* row);
+        void (*clamp)(const int16_t* input, uint8_t* output, int count);
+        int32_t (*dot)(const uint8_t* input, const int8_t* weights, int count); // count % 32 == 0
+    };
+
+    // Picks the widest kernels the running CPU supports
+    Kernels select_kernels()
+    {
+#ifdef NNUE_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            return {"avx2", add_row_avx2, sub_row_avx2, clamp_avx2, dot_avx2};
+        if (__builtin_cpu_supports("ssse3"))
+            return {"ssse3", add_row_ssse3, sub_row_ssse3, clamp_ssse3, dot_ssse3};
+#endif
+        return {"scalar", add_row_scalar, sub_row_scalar, clamp_scalar, dot_scalar};
+    }
+
+    const Kernels kernels = select_kernels();
+
+    // Input feature of a piece as seen by one side; black's view is mirrored
+    int feature_index(int perspective, int piece, int square)
+    {
+        if (perspective == WHITE)
+            return piece_index(piece) * 64 + square;
+        return piece_index(-piece) * 64 + (square ^ 56);
+    }
+
+    // Runs the dense layers on the side to move's and the other side's accumulators
+    int forward(const int16_t* us, const int16_t* them)
+    {
+        alignas(64) uint8_t input[2 * NNUE_HIDDEN];
+        alignas(64) uint8_t hidden2[NNUE_L2];
+        alignas(64) uint8_t hidden3[NNUE_L3];
+
+        kernels.clamp(us, input, NNUE_HIDDEN);
+        kernels.clamp(them, input + NNUE_HIDDEN, NNUE_HIDDEN);
+
+        for (int i = 0; i < NNUE_L2; ++i)
+        {
+            int32_t sum = network->l2_bias[i] + kernels.dot(input, network->l2_weights[i], 2 * NNUE_HIDDEN);
+            hidden2[i] = static_cast<uint8_t>(std::clamp(sum >> DENSE_SHIFT, 0, 127));
+        }
+        for (int i = 0; i < NNUE_L3; ++i)
+        {
+            int32_t sum = network->l3_bias[i] + kernels.dot(hidden2, network->l3_weights[i], NNUE_L2);
+            hidden3[i] = static_cast<uint8_t>(std::clamp(sum >> DENSE_SHIFT, 0, 127));
+        }
+        return (network->out_bias + kernels.dot(hidden3, network->out_weights, NNUE_L3)) / OUTPUT_DIVISOR;
+    }
+}
+
+bool nnue_load(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    char magic[4];
+    uint32_t version = 0, hidden = 0;
+    if (!file.read(magic, 4) || std::string(magic, 4) != "NNUE" ||
+        !file.read(reinterpret_cast<char*>(&version), 4) || version != FILE_VERSION ||
+        !file.read(reinterpret_cast<char*>(&hidden), 4) || hidden != NNUE_HIDDEN)
+    {
+        std::cout << "Not a supported network file: " << path << "\n";
+        return false;
+    }
+
+    auto loaded = std::make_unique<Network>();
+    auto read = [&file](void* data, size_t size) { return static_cast<bool>(file.read(static_cast<char*>(data), size)); };
+    if (!read(loaded->feature_weights, sizeof(loaded->feature_weights)) ||
+        !read(loaded->feature_bias, sizeof(loaded->feature_bias)) ||
+        !read(loaded->l2_weights, sizeof(loaded->l2_weights)) ||
+        !read(loaded->l2_bias, sizeof(loaded->l2_bias)) ||
+        !read(loaded->l3_weights, sizeof(loaded->l3_weights)) ||
+        !read(loaded->l3_bias, sizeof(loaded->l3_bias)) ||
+        !read(loaded->out_weights, sizeof(loaded->out_weights)) ||
+        !read(&loaded->out_bias, sizeof(loaded->out_bias)))
+    {
+        std::cout << "Truncated network file: " << path << "\n";
+        return false;
+    }
+
+    network = std::move(loaded);
+    return true;
+}
+
+bool nnue_save(const std::string& path)
+{
+    if (!network)
+        return false;
+
+    std::ofstream file(path, std::ios::binary);
+    uint32_t version = FILE_VERSION, hidden = NNUE_HIDDEN;
+    file.write("NNUE", 4);
+    file.write(reinterpret_cast<const char*>(&version), 4);
+    file.write(reinterpret_cast<const char*>(&hidden), 4);
+    file.write(reinterpret_cast<const char*>(network->feature_weights), sizeof(network->feature_weights));
+    file.write(reinterpret_cast<const char*>(network->feature_bias), sizeof(network->feature_bias));
+    file.write(reinterpret_cast<const char*>(network->l2_weights), sizeof(network->l2_weights));
+    file.write(reinterpret_cast<const char*>(network->l2_bias), sizeof(network->l2_bias));
+    file.write(reinterpret_cast<const char*>(network->l3_weights), sizeof(network->l3_weights));
+    file.write(reinterpret_cast<const char*>(network->l3_bias), sizeof(network->l3_bias));
+    file.write(reinterpret_cast<const char*>(network->out_weights), sizeof(network->out_weights));
+    file.write(reinterpret_cast<const char*>(&network->out_bias), sizeof(network->out_bias));
+    return static_cast<bool>(file);
+}
+
+void nnue_init_random(uint32_t seed)
+{
+    std::mt19937 generator(seed);
+    auto random = [&generator](int low, int high) { return std::uniform_int_distribution<int>(low, high)(generator); };
+
+    auto random_network = std::make_unique<Network>();
+    for (auto& row : random_network->feature_weights)
+        for (auto& weight : row)
+            weight = static_cast<int16_t>(random(-16, 16));
+    for (auto& bias : random_network->feature_bias)
+        bias = static_cast<int16_t>(random(0, 64));
+    for (auto& row : random_network->l2_weights)
+        for (auto& weight : row)
+            weight = static_cast<int8_t>(random(-8, 8));
+    for (auto& bias : random_network->l2_bias)
+        bias = random(-256, 256);
+    for (auto& row : random_network->l3_weights)
+        for (auto& weight : row)
+            weight = static_cast<int8_t>(random(-32, 32));
+    for (auto& bias : random_network->l3_bias)
+        bias = random(-256, 256);
+    for (auto& weight : random_network->out_weights)
+        weight = static_cast<int8_t>(random(-64, 64));
+    random_network->out_bias = 0;
+    network = std::move(random_network);
+}
+
+bool nnue_loaded()
+{
+    return network != nullptr;
+}
+
+void nnue_set_enabled(bool enable)
+{
+    enabled = enable;
+}
+
+bool nnue_enabled()
+{
+    return enabled && network;
+}
+
+const char* nnue_kernel_name()
+{
+    return kernels.name;
+}
+
+void nnue_refresh(const Position& pos, NNUEAccumulator& accumulator)
+{
+    for (int perspective = WHITE; perspective <= BLACK; ++perspective)
+    {
+        std::copy(network->feature_bias, network->feature_bias + NNUE_HIDDEN, accumulator.values[perspective]);
+        Bitboard pieces = pos.occupied;
+        while (pieces)
+        {
+            int square = pop_lsb(pieces);
+            int feature = feature_index(perspective, pos.piece_on(square), square);
+            kernels.add_row(accumulator.values[perspective], network->feature_weights[feature]);
+        }
+    }
+}
+
+int nnue_evaluate(const Position& pos, const NNUEAccumulator& accumulator)
+{
+    int us = color_index(pos.turn);
+    return forward(accumulator.values[us], accumulator.values[us ^ 1]);
+}
+
+int nnue_evaluate(const Position& pos)
+{
+    NNUEAccumulator accumulator;
+    nnue_refresh(pos, accumulator);
+    return nnue_evaluate(pos, accumulator);
+}
+
+void NNUEStack::reset(const Position& pos)
+{
+    top = 0;
+    nnue_refresh(pos, entries[0].accumulator);
+    entries[0].computed = true;
+}
+
+// Records the pieces the move adds, removes or relocates, before it is made
+void NNUEStack::push(const Position& before, Move move)
+{
+    Entry& entry = entries[++top];
+    entry.computed = false;
+    entry.dirty_count = 0;
+
+    int from = move.from();
+    int to = move.to();
+    int player = before.turn;
+    int piece = before.piece_on(from);
+
+    if (move.flags() == MOVE_EN_PASSANT)
+        entry.dirty[entry.dirty_count++] = {PAWN_WHITE * -player, to - 8 * player, NO_SQUARE};
+    else if (move.is_capture())
+        entry.dirty[entry.dirty_count++] = {before.piece_on(to), to, NO_SQUARE};
+
+    if (move.is_promotion())
+    {
+        entry.dirty[entry.dirty_count++] = {piece, from, NO_SQUARE};
+        entry.dirty[entry.dirty_count++] = {move.promotion_type() * player, NO_SQUARE, to};
+    }
+    else
+        entry.dirty[entry.dirty_count++] = {piece, from, to};
+
+    if (move.flags() == MOVE_KING_CASTLE)
+        entry.dirty[entry.dirty_count++] = {ROOK_WHITE * player, to + 1, to - 1};
+    else if (move.flags() == MOVE_QUEEN_CASTLE)
+        entry.dirty[entry.dirty_count++] = {ROOK_WHITE * player, to - 2, to + 1};
+}
+
+void NNUEStack::push_null()
+{
+    Entry& entry = entries[++top];
+    entry.computed = false;
+    entry.dirty_count = 0;
+}
+
+// Replays the recorded changes from the nearest up-to-date accumulator
+int NNUEStack::evaluate(const Position& pos)
+{
+    int base = top;
+    while (!entries[base].computed)
+        --base;
+
+    for (int i = base + 1; i <= top; ++i)
+    {
+        Entry& entry = entries[i];
+        entry.accumulator = entries[i - 1].accumulator;
+        for (int j = 0; j < entry.dirty_count; ++j)
+        {
+            const DirtyPiece& dirty = entry.dirty[j];
+            for (int perspective = WHITE; perspective <= BLACK; ++perspective)
+            {
+                int16_t* values = entry.accumulator.values[perspective];
+                if (dirty.from != NO_SQUARE)
+                    kernels.sub_row(values, network->feature_weights[feature_index(perspective, dirty.piece, dirty.from)]);
+                if (dirty.to != NO_SQUARE)
+                    kernels.add_row(values, network->feature_weights[feature_index(perspective, dirty.piece, dirty.to)]);
+            }
+        }
+        entry.computed = true;
+    }
+    return nnue_evaluate(pos, entries[top].accumulator);
+}
+
+int nnue_bench_command(const std::vector<std::string>& args)
+{
+    if (args.size() > 1)
+    {
+        if (!nnue_load(args[1]))
+            return 1;
+    }
+    else
+    {
+        std::cout << "No weights file given, timing an untrained network\n";
+        nnue_init_random(1);
+    }
+    std::cout << "NNUE kernels: " << nnue_kernel_name() << "\n";
+
+    // Positions from seeded random games
+    std::mt19937 generator(7);
+    std::vector<Position> positions;
+    Board board(false);
+    while (positions.size() < 20000)
+    {
+        board.initialize();
+        for (int ply = 0; ply < 120; ++ply)
+        {
+            MoveList moves;
+            generate_legal_moves(board, moves);
+            if (moves.empty())
+                break;
+            board.make_move(moves[generator() % moves.size()]);
+            positions.push_back(board.get_position());
+        }
+    }
+
+    typedef std::chrono::steady_clock Clock;
+    auto rate = [](size_t count, Clock::time_point start)
+    {
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        return static_cast<uint64_t>(seconds > 0 ? count / seconds : 0);
+    };
+
+    int64_t checksum = 0;
+    auto start = Clock::now();
+    for (const Position& pos : positions)
+        checksum += evaluate_classical(pos, pos.turn);
+    std::cout << "Classical eval:        " << rate(positions.size(), start) << " evals/s\n";
+
+    start = Clock::now();
+    for (const Position& pos : positions)
+        checksum += nnue_evaluate(pos);
+    std::cout << "NNUE full refresh:     " << rate(positions.size(), start) << " evals/s\n";
+
+    // Incremental: one move and one evaluation per step, as in a search
+    NNUEStack stack;
+    size_t evaluations = 0;
+    start = Clock::now();
+    for (int game = 0; game < 200; ++game)
+    {
+        board.initialize();
+        stack.reset(board.get_position());
+        for (int ply = 0; ply < 100; ++ply)
+        {
+            MoveList moves;
+            generate_legal_moves(board, moves);
+            if (moves.empty())
+                break;
+            Move move = moves[generator() % moves.size()];
+            stack.push(board.get_position(), move);
+            board.make_move(move);
+            checksum += stack.evaluate(board.get_position());
+            ++evaluations;
+        }
+    }
+    std::cout << "NNUE incremental:      " << rate(evaluations, start) << " evals/s (including move generation)\n";
+
+    // Search speed with each backend
+    const char* fens[] =
+    {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    };
+    for (bool use_nnue : {false, true})
+    {
+        nnue_set_enabled(use_nnue);
+        SearchLimits limits;
+        limits.depth = 7;
+        uint64_t nodes = 0;
+        double seconds = 0;
+        for (const char* fen : fens)
+        {
+            Board search_board(false);
+            search_board.from_fen(fen);
+            TT.clear();
+            SearchResult result = search(search_board, limits);
+            nodes += result.stats.nodes;
+            seconds += result.stats.seconds;
+        }
+        std::cout << (use_nnue ? "Search NPS, NNUE:      " : "Search NPS, classical: ")
+                  << static_cast<uint64_t>(seconds > 0 ? nodes / seconds : 0) << " nodes/s\n";
+    }
+    nnue_set_enabled(true);
+
+    std::cout << "(checksum " << checksum << ")\n";
+    return 0;
+}
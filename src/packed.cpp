@@ -0,0 +1,87 @@
+// packed.cpp
+#include "packed.hpp"
+
+bool pack_position(const Position& pos, int fullmove, PackedPosition& packed)
+{
+    if (pop_count(pos.occupied) > 32)
+        return false;
+
+    packed = PackedPosition{};
+    packed.occupied = pos.occupied;
+
+    Bitboard occupied = pos.occupied;
+    for (int i = 0; occupied; ++i)
+    {
+        int square = pop_lsb(occupied);
+        packed.pieces[i / 2] |= piece_index(pos.piece_on(square)) << ((i & 1) * 4);
+    }
+
+    packed.flags = static_cast<uint8_t>((pos.turn == -1 ? 1 : 0) | pos.castling << 1);
+    packed.en_passant = pos.en_passant;
+    packed.halfmove = static_cast<uint8_t>(pos.fifty_move_counter < 255 ? pos.fifty_move_counter : 255);
+    packed.fullmove = static_cast<uint16_t>(fullmove);
+    return true;
+}
+
+bool unpack_position(const PackedPosition& packed, Position& pos, int& fullmove)
+{
+    pos = Position{};   // Not clear(): its full key scan would dominate the decode
+    if (pop_count(packed.occupied) > 32 ||
+        (packed.en_passant != NO_SQUARE && (packed.en_passant < 0 || packed.en_passant > 63)))
+    {
+        pos.clear();
+        return false;
+    }
+    pos.occupied = packed.occupied;
+
+    // Same bookkeeping as add_piece, with the occupancy already known
+    Bitboard occupied = packed.occupied;
+    for (int i = 0; occupied; ++i)
+    {
+        int square = pop_lsb(occupied);
+        int index = (packed.pieces[i / 2] >> ((i & 1) * 4)) & 15;
+        if (index >= 12)
+        {
+            pos.clear();
+            return false;
+        }
+        int piece = index_piece(index);
+        pos.pieces[index] |= square_bb(square);
+        pos.squares[square] = static_cast<int8_t>(piece);
+        pos.key ^= ZOBRIST.piece[index][square];
+        pos.mg_score += PSQT.mg[index][square];
+        pos.eg_score += PSQT.eg[index][square];
+        pos.phase += PHASE_WEIGHTS[piece_type(piece)];
+    }
+    for (int index = 0; index < 6; ++index)
+    {
+        pos.occupancy[WHITE] |= pos.pieces[index];
+        pos.occupancy[BLACK] |= pos.pieces[index + 6];
+    }
+    if (pos.pawns_on_back_ranks())
+    {
+        pos.clear();
+        return false;
+    }
+
+    pos.turn = packed.flags & 1 ? -1 : 1;
+    pos.castling = (packed.flags >> 1) & pos.castling_possible();
+    pos.en_passant = packed.en_passant;
+    pos.fifty_move_counter = packed.halfmove;
+    pos.key ^= ZOBRIST.castling[pos.castling];
+    if (pos.en_passant != NO_SQUARE)
+        pos.key ^= ZOBRIST.en_passant[square_col(pos.en_passant)];
+    if (pos.turn == -1)
+        pos.key ^= ZOBRIST.side;
+    fullmove = packed.fullmove;
+    return true;
+}
+
+size_t unpack_positions(const PackedPosition* packed, Position* positions, size_t count)
+{
+    size_t valid = 0;
+    int fullmove;
+    for (size_t i = 0; i < count; ++i)
+        valid += unpack_position(packed[i], positions[i], fullmove);
+    return valid;
+}
@@ -0,0 +1,188 @@
+// perft.cpp
+#include "perft.hpp"
+#include "movegen.hpp"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <iostream>
+#include <iomanip>
+
+namespace
+{
+    struct PerftCase
+    {
+        const char* name;
+        const char* fen;
+        std::vector<uint64_t> counts; // Expected nodes for depth 1, 2, ...
+    };
+
+    // Standard reference positions with their published node counts
+    const std::vector<PerftCase> REFERENCE_POSITIONS =
+    {
+        {"start", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+            {20, 400, 8902, 197281, 4865609, 119060324}},
+        {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+            {48, 2039, 97862, 4085603, 193690690}},
+        {"position 3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+            {14, 191, 2812, 43238, 674624, 11030083}},
+        {"position 4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+            {6, 264, 9467, 422333, 15833292}},
+        {"position 5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+            {44, 1486, 62379, 2103487, 89941194}},
+        {"position 6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+            {46, 2079, 89890, 3894594, 164075551}},
+    };
+
+    int default_threads()
+    {
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    void print_rate(uint64_t nodes, double seconds)
+    {
+        std::cout << nodes << " nodes in " << std::fixed << std::setprecision(3) << seconds << " s ("
+                  << static_cast<uint64_t>(seconds > 0 ? nodes / seconds : 0) << " nodes/s)\n";
+    }
+
+    int run_suite(int max_depth, int threads)
+    {
+        int failures = 0;
+        uint64_t total_nodes = 0;
+        double total_seconds = 0;
+
+        for (const auto& test : REFERENCE_POSITIONS)
+        {
+            Board board(false);
+            board.from_fen(test.fen);
+            int depth_limit = std::min<int>(max_depth, test.counts.size());
+            for (int depth = 1; depth <= depth_limit; ++depth)
+            {
+                PerftResult result = run_perft(board, depth, threads);
+                bool ok = result.nodes == test.counts[depth - 1];
+                failures += !ok;
+                total_nodes += result.nodes;
+                total_seconds += result.seconds;
+
+                std::cout << std::left << std::setw(12) << test.name << " depth " << depth << "  "
+                          << (ok ? "ok    " : "FAILED") << "  ";
+                print_rate(result.nodes, result.seconds);
+                if (!ok)
+                    std::cout << "    expected " << test.counts[depth - 1] << "\n";
+            }
+        }
+
+        std::cout << "Total: ";
+        print_rate(total_nodes, total_seconds);
+        std::cout << (failures ? "Perft suite FAILED\n" : "Perft suite passed\n");
+        return failures ? 1 : 0;
+    }
+}
+
+uint64_t perft(Board& board, int depth)
+{
+    if (depth <= 0)
+        return 1;
+
+    MoveList moves;
+    generate_legal_moves(board, moves);
+    if (depth == 1)
+        return moves.size();
+
+    uint64_t nodes = 0;
+    for (Move move : moves)
+    {
+        board.make_move(move);
+        nodes += perft(board, depth - 1);
+        board.unmake_move();
+    }
+    return nodes;
+}
+
+PerftResult run_perft(const Board& board, int depth, int threads, bool divide)
+{
+    PerftResult result;
+    auto start = std::chrono::steady_clock::now();
+
+    Board root = board;
+    MoveList moves;
+    generate_legal_moves(root, moves);
+
+    // Workers pull root moves from a shared counter, each on its own copy of the board
+    std::vector<uint64_t> counts(moves.size(), 0);
+    std::atomic<int> next_move{0};
+    auto worker = [&]()
+    {
+        Board local = board;
+        for (int i = next_move++; i < moves.size(); i = next_move++)
+        {
+            local.make_move(moves[i]);
+            counts[i] = perft(local, depth - 1);
+            local.unmake_move();
+        }
+    };
+
+    if (depth <= 0)
+        result.nodes = 1;
+    else
+    {
+        int workers = std::max(1, std::min<int>(threads, moves.size()));
+        std::vector<std::thread> pool;
+        for (int i = 1; i < workers; ++i)
+            pool.emplace_back(worker);
+        worker();
+        for (auto& thread : pool)
+            thread.join();
+
+        for (int i = 0; i < moves.size(); ++i)
+        {
+            result.nodes += counts[i];
+            if (divide)
+                result.divide.emplace_back(moves[i], counts[i]);
+        }
+    }
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+int perft_command(const std::vector<std::string>& args)
+{
+    // Options: "-t N" sets the thread count, the remaining words are depth and FEN
+    int threads = default_threads();
+    std::vector<std::string> words;
+    for (size_t i = 1; i < args.size(); ++i)
+    {
+        if (args[i] == "-t" && i + 1 < args.size())
+            threads = std::max(1, std::atoi(args[++i].c_str()));
+        else
+            words.push_back(args[i]);
+    }
+
+    if (!words.empty() && words[0] == "suite")
+        return run_suite(words.size() > 1 ? std::atoi(words[1].c_str()) : 5, threads);
+
+    bool divide = args[0] == "divide";
+    int depth = words.empty() ? 5 : std::atoi(words[0].c_str());
+
+    Board board(false);
+    if (words.size() > 1)
+    {
+        std::string fen;
+        for (size_t i = 1; i < words.size(); ++i)
+            fen += words[i] + " ";
+        if (!board.from_fen(fen))
+        {
+            std::cout << "Invalid FEN: " << fen << "\n";
+            return 1;
+        }
+    }
+    else
+        board.initialize();
+
+    PerftResult result = run_perft(board, depth, threads, divide);
+    for (const auto& [move, nodes] : result.divide)
+        std::cout << move_to_string(move) << ": " << nodes << "\n";
+    std::cout << "Depth " << depth << ": ";
+    print_rate(result.nodes, result.seconds);
+    return 0;
+}
@@ -0,0 +1,678 @@
+// search.cpp
+#include "search.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <iostream>
+#include <iomanip>
+#include <iterator>
+#include <memory>
+#include <cstdlib>
+#include "ai.hpp"
+#include "instrument.hpp"
+#include "movegen.hpp"
+#include "movepick.hpp"
+#include "nnue.hpp"
+#include "tablebase.hpp"
+#include "tt.hpp"
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    // Mate and tablebase scores count plies from the root; they are stored
+    // relative to the node so they stay right when read back at another ply
+    int score_to_tt(int score, int ply)
+    {
+        return score > TB_BOUND ? score + ply : score < -TB_BOUND ? score - ply : score;
+    }
+
+    int score_from_tt(int score, int ply)
+    {
+        return score > TB_BOUND ? score - ply : score < -TB_BOUND ? score + ply : score;
+    }
+
+    // Quiescence and SEE pruning margins, in centipawns
+    constexpr int DELTA_MARGIN = 200;
+    constexpr int SEE_PRUNING_DEPTH = 3;
+    constexpr int SEE_PRUNING_MARGIN = 100;
+
+    // Selective search thresholds: margins in centipawns per ply of depth left
+    constexpr int REVERSE_FUTILITY_DEPTH = 6;
+    constexpr int REVERSE_FUTILITY_MARGIN = 80;
+    constexpr int FUTILITY_DEPTH = 3;
+    constexpr int FUTILITY_MARGIN = 120;
+    constexpr int NULL_MOVE_DEPTH = 3;
+    constexpr int LMR_DEPTH = 3;
+    constexpr int ASPIRATION_DEPTH = 5;
+    constexpr int ASPIRATION_WINDOW = 25;
+
+    // Late move reductions grow with the log of both the depth and the move number
+    struct ReductionTable
+    {
+        int values[64][64];
+
+        ReductionTable()
+        {
+            for (int depth = 0; depth < 64; ++depth)
+                for (int count = 0; count < 64; ++count)
+                    values[depth][count] = depth && count ? static_cast<int>(0.75 + std::log(depth) * std::log(count) / 2.25) : 0;
+        }
+
+        const int* operator[](int depth) const { return values[depth]; }
+    };
+
+    const ReductionTable LMR_TABLE;
+
+    // Helper threads skip some iteration depths so they spread over different
+    // depths instead of all searching the same tree (pattern cycles every 20 threads)
+    const int SKIP_SIZE[20] = {1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+    const int SKIP_PHASE[20] = {0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
+
+    // State every search thread of one search can see
+    struct SharedSearch
+    {
+        explicit SharedSearch(TranspositionTable& tt) : tt(tt) {}
+
+        TranspositionTable& tt;
+        std::atomic<bool> stop{false};
+        Clock::time_point start = Clock::now();
+    };
+
+    class Searcher
+    {
+        public:
+            Searcher(Board& board, const SearchLimits& limits, SharedSearch& shared, int thread_id)
+                : board(board), limits(limits), shared(shared), thread_id(thread_id), start(shared.start), budget_start(shared.start)
+            {
+                history.clear();
+            }
+
+            SearchResult run();
+
+        private:
+            Board& board;
+            SearchLimits limits;
+            SharedSearch& shared;
+            int thread_id;                  // 0 is the main thread
+            Clock::time_point start;
+            uint64_t nodes = 0;
+            bool stopped = false;
+            SearchStats stats;
+
+            // Triangular PV table: pv[ply] holds the best line found from that ply
+            Move pv[MAX_PLY + 1][MAX_PLY + 1];
+            int pv_length[MAX_PLY + 1];
+            std::vector<Move> previous_pv;
+
+            HistoryTables history;
+            Move move_stack[MAX_PLY + 1];   // Move played at each ply, for countermoves
+
+            // Network accumulators follow the search stack when the network is in use
+            bool use_nnue = nnue_enabled();
+            std::unique_ptr<NNUEStack> nnue;
+
+            void make(Move move)
+            {
+                if (use_nnue)
+                    nnue->push(board.get_position(), move);
+                board.make_move(move);
+            }
+
+            void unmake()
+            {
+                if (use_nnue)
+                    nnue->pop();
+                board.unmake_move();
+            }
+
+            void make_null()
+            {
+                if (use_nnue)
+                    nnue->push_null();
+                board.make_null_move();
+            }
+
+            void unmake_null()
+            {
+                if (use_nnue)
+                    nnue->pop();
+                board.unmake_null_move();
+            }
+
+            int evaluate()
+            {
+                INSTRUMENT_SCOPE(Probe::Evaluate);
+                if (use_nnue)
+                    return nnue->evaluate(board.get_position());
+                return evaluate_classical(board.get_position(), board.get_turn());
+            }
+
+            int negamax(int depth, int ply, int alpha, int beta, bool allow_null = true);
+            int quiescence(int ply, int alpha, int beta);
+            int aspiration_search(int depth, int previous_score);
+            bool out_of_budget();
+            double elapsed() const
+            {
+                return std::chrono::duration<double>(Clock::now() - start).count();
+            }
+
+            // Time charged to the budget, counted from the ponder hit when pondering
+            Clock::time_point budget_start;
+            int64_t budget_elapsed_ms() const
+            {
+                return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - budget_start).count();
+            }
+            bool pondering() const
+            {
+                return limits.ponder && limits.ponder->load(std::memory_order_relaxed);
+            }
+    };
+
+    // Stop requests are seen at every node. Only the main thread watches the
+    // budget, reading the clock every 1024 nodes to keep it cheap; helpers
+    // follow the shared stop flag. While pondering the clock is held at zero.
+    bool Searcher::out_of_budget()
+    {
+        if (shared.stop.load(std::memory_order_relaxed) ||
+            (limits.stop && limits.stop->load(std::memory_order_relaxed)))
+            stopped = true;
+        else if (thread_id == 0 && (nodes & 1023) == 0)
+        {
+            if (pondering())
+                budget_start = Clock::now();
+            else if ((limits.nodes && nodes >= limits.nodes) ||
+                     (limits.time_ms && budget_elapsed_ms() >= limits.time_ms))
+                stopped = true;
+        }
+        return stopped;
+    }
+
+    int Searcher::negamax(int depth, int ply, int alpha, int beta, bool allow_null)
+    {
+        pv_length[ply] = ply;
+        ++nodes;
+        if (out_of_budget())
+            return 0;
+
+        if (ply > 0 && (board.get_fifty_move_counter() >= 100 || board.is_repetition()))
+            return 0;
+        if (ply >= MAX_PLY)
+            return evaluate();
+
+        // Small endgames have an exact value on disk
+        TBResult outcome;
+        if (ply > 0 && pop_count(board.get_position().occupied) <= TB_MAX_PIECES &&
+            TABLEBASES.probe(board.get_position(), outcome))
+        {
+            ++stats.tb_hits;
+            return tablebase_score(outcome, ply);
+        }
+
+        if (depth <= 0)
+            return quiescence(ply, alpha, beta);
+
+        // Nodes searched with an open window; the others only need a bound
+        bool pv_node = beta - alpha > 1;
+        const SearchFeatures& features = limits.features;
+
+        // A deep enough stored result with a usable bound ends the node
+        uint64_t key = board.get_key();
+        TTData entry;
+        Move tt_move = NULL_MOVE;
+        ++stats.tt_probes;
+        if (shared.tt.probe(key, entry))
+        {
+            ++stats.tt_hits;
+            tt_move = entry.move;
+            int tt_score = score_from_tt(entry.score, ply);
+            if (!pv_node && entry.depth >= depth &&
+                (entry.bound == BOUND_EXACT ||
+                 (entry.bound == BOUND_LOWER && tt_score >= beta) ||
+                 (entry.bound == BOUND_UPPER && tt_score <= alpha)))
+                return tt_score;
+        }
+
+        bool in_check = board.is_in_check(board.get_turn());
+        int static_eval = in_check ? -INFINITE_SCORE : evaluate();
+
+        if (!pv_node && !in_check && std::abs(beta) < MATE_BOUND)
+        {
+            // Reverse futility: far enough above beta that a shallow search will not come back down
+            if (features.reverse_futility && depth <= REVERSE_FUTILITY_DEPTH &&
+                static_eval - REVERSE_FUTILITY_MARGIN * depth >= beta)
+                return static_eval;
+
+            // Null move: if passing still fails high, a real move would too. Not done without
+            // pieces, where zugzwang makes passing the best option, nor twice in a row.
+            if (features.null_move && allow_null && depth >= NULL_MOVE_DEPTH && static_eval >= beta &&
+                board.get_position().has_non_pawn_material(board.get_turn()))
+            {
+                int reduction = 3 + depth / 4 + std::min((static_eval - beta) / 200, 3);
+                move_stack[ply] = NULL_MOVE;
+                make_null();
+                int score = -negamax(depth - 1 - reduction, ply + 1, -beta, -beta + 1, false);
+                unmake_null();
+                if (stopped)
+                    return 0;
+                if (score >= beta)
+                    return score > MATE_BOUND ? beta : score;
+            }
+        }
+
+        // Futility: quiet moves cannot lift a static eval this far below alpha back up
+        bool futile = features.futility && !pv_node && !in_check && depth <= FUTILITY_DEPTH &&
+                      std::abs(alpha) < MATE_BOUND && static_eval + FUTILITY_MARGIN * depth <= alpha;
+
+        // Without a stored move, the previous iteration's principal variation leads
+        if (tt_move == NULL_MOVE && ply < static_cast<int>(previous_pv.size()))
+            tt_move = previous_pv[ply];
+        MovePicker picker(board, history, tt_move, ply, ply > 0 ? move_stack[ply - 1] : NULL_MOVE);
+        if (picker.legal_count() == 0)
+            return in_check ? -MATE_SCORE + ply : 0;
+
+        int original_alpha = alpha;
+        Move best_move = NULL_MOVE;
+        int best_score = -INFINITE_SCORE;
+        Move quiets_tried[MAX_MOVES];
+        int quiet_count = 0;
+        int move_count = 0;
+        for (Move move = picker.next(); move != NULL_MOVE; move = picker.next())
+        {
+            bool quiet = !move.is_capture() && !move.is_promotion();
+
+            // Near the leaves, captures that lose clearly more than a pawn per ply left are not searched
+            if (move_count > 0 && !in_check && depth <= SEE_PRUNING_DEPTH && move.is_capture() &&
+                best_score > -MATE_BOUND && see(board.get_position(), move) < -SEE_PRUNING_MARGIN * depth)
+                continue;
+
+            move_stack[ply] = move;
+            make(move);
+            bool gives_check = board.is_in_check(board.get_turn());
+            if (futile && move_count > 0 && quiet && !gives_check)
+            {
+                unmake();
+                continue;
+            }
+            ++move_count;
+
+            // Principal variation search: the first move gets the full window, later ones
+            // a null window, reduced when ordered late, and a re-search if they beat alpha
+            int new_depth = depth - 1;
+            int score;
+            if (move_count == 1)
+                score = -negamax(new_depth, ply + 1, -beta, -alpha);
+            else
+            {
+                int reduction = 0;
+                if (features.late_move_reductions && depth >= LMR_DEPTH && move_count > (pv_node ? 3 : 2) &&
+                    quiet && !in_check && !gives_check)
+                {
+                    reduction = LMR_TABLE[std::min(depth, 63)][std::min(move_count, 63)] - pv_node;
+                    reduction = std::clamp(reduction, 0, new_depth - 1);
+                }
+
+                score = -negamax(new_depth - reduction, ply + 1, -alpha - 1, -alpha);
+                if (score > alpha && reduction > 0)
+                    score = -negamax(new_depth, ply + 1, -alpha - 1, -alpha);
+                if (score > alpha && score < beta)
+                    score = -negamax(new_depth, ply + 1, -beta, -alpha);
+            }
+            unmake();
+            if (stopped)
+                return 0;
+
+            if (score > best_score)
+            {
+                best_score = score;
+                best_move = move;
+                if (score > alpha)
+                {
+                    alpha = score;
+                    pv[ply][ply] = move;
+                    for (int i = ply + 1; i < pv_length[ply + 1]; ++i)
+                        pv[ply][i] = pv[ply + 1][i];
+                    pv_length[ply] = pv_length[ply + 1];
+                    if (alpha >= beta)
+                    {
+                        ++stats.beta_cutoffs;
+                        if (move_count == 1)
+                            ++stats.first_move_cutoffs;
+                        if (quiet)
+                            history.update(board.get_position(), move, quiets_tried, quiet_count, depth, ply,
+                                           ply > 0 ? move_stack[ply - 1] : NULL_MOVE);
+                        break;
+                    }
+                }
+            }
+            if (quiet)
+                quiets_tried[quiet_count++] = move;
+        }
+
+        int bound = best_score >= beta ? BOUND_LOWER : best_score > original_alpha ? BOUND_EXACT : BOUND_UPPER;
+        ++stats.tt_stores;
+        if (shared.tt.store(key, best_move, score_to_tt(best_score, ply), static_eval, depth, bound))
+            ++stats.tt_collisions;
+        return best_score;
+    }
+
+    // Resolves captures and promotions until the position is quiet, so leaves are
+    // not scored in the middle of an exchange. The side to move may stand pat on
+    // the static evaluation unless in check, where every evasion is searched.
+    int Searcher::quiescence(int ply, int alpha, int beta)
+    {
+        pv_length[ply] = ply;
+        ++nodes;
+        if (out_of_budget())
+            return 0;
+        if (ply >= MAX_PLY)
+            return evaluate();
+
+        bool in_check = board.is_in_check(board.get_turn());
+        int stand_pat = -INFINITE_SCORE;
+        if (!in_check)
+        {
+            stand_pat = evaluate();
+            if (stand_pat >= beta)
+                return stand_pat;
+            alpha = std::max(alpha, stand_pat);
+        }
+
+        MovePicker picker(board, history, NULL_MOVE, ply, move_stack[ply - 1], !in_check);
+        if (in_check && picker.legal_count() == 0)
+            return -MATE_SCORE + ply;
+
+        int best_score = stand_pat;
+        for (Move move = picker.next(); move != NULL_MOVE; move = picker.next())
+        {
+            // Delta pruning: even winning the piece outright would not reach alpha
+            if (!in_check && !move.is_promotion())
+            {
+                int victim = move.flags() == MOVE_EN_PASSANT ? PAWN_WHITE : piece_type(board.get_position().piece_on(move.to()));
+                if (stand_pat + SEE_VALUES[victim] + DELTA_MARGIN <= alpha)
+                    continue;
+            }
+
+            move_stack[ply] = move;
+            make(move);
+            int score = -quiescence(ply + 1, -beta, -alpha);
+            unmake();
+            if (stopped)
+                return 0;
+
+            if (score > best_score)
+            {
+                best_score = score;
+                if (score > alpha)
+                {
+                    alpha = score;
+                    if (alpha >= beta)
+                        break;
+                }
+            }
+        }
+        return best_score;
+    }
+
+    // Searches the root in a narrow window around the previous score, widening
+    // it on the failing side until the score falls inside
+    int Searcher::aspiration_search(int depth, int previous_score)
+    {
+        if (!limits.features.aspiration || depth < ASPIRATION_DEPTH || std::abs(previous_score) > MATE_BOUND)
+            return negamax(depth, 0, -INFINITE_SCORE, INFINITE_SCORE);
+
+        int window = ASPIRATION_WINDOW;
+        int alpha = std::max(previous_score - window, -INFINITE_SCORE);
+        int beta = std::min(previous_score + window, INFINITE_SCORE);
+        while (true)
+        {
+            int score = negamax(depth, 0, alpha, beta);
+            if (stopped)
+                return 0;
+            if (score <= alpha)
+                alpha = std::max(score - window, -INFINITE_SCORE);
+            else if (score >= beta)
+                beta = std::min(score + window, INFINITE_SCORE);
+            else
+                return score;
+            window *= 2;
+        }
+    }
+
+    SearchResult Searcher::run()
+    {
+        SearchResult result;
+        MoveList root_moves;
+        generate_legal_moves(board, root_moves);
+        if (root_moves.empty())
+            return result;
+        result.best_move = root_moves[0]; // Fallback if not even depth 1 completes
+        if (use_nnue)
+        {
+            nnue = std::make_unique<NNUEStack>();
+            nnue->reset(board.get_position());
+        }
+
+        uint64_t previous_iteration_nodes = 0;
+        for (int depth = 1; depth <= limits.depth; ++depth)
+        {
+            // Helpers skip depths by their pattern, but never the first or the last
+            int pattern = (thread_id - 1) % 20;
+            if (thread_id > 0 && depth > 1 && depth < limits.depth &&
+                ((depth + SKIP_PHASE[pattern]) / SKIP_SIZE[pattern]) % 2)
+                continue;
+
+            uint64_t iteration_start = nodes;
+            int score = aspiration_search(depth, result.score);
+            if (stopped)
+                break;
+
+            // Growth of the tree from one completed iteration to the next
+            uint64_t iteration_nodes = nodes - iteration_start;
+            if (previous_iteration_nodes)
+                stats.branching_factor = static_cast<double>(iteration_nodes) / previous_iteration_nodes;
+            previous_iteration_nodes = iteration_nodes;
+
+            previous_pv.assign(pv[0], pv[0] + pv_length[0]);
+            result.pv = previous_pv;
+            result.best_move = previous_pv.empty() ? root_moves[0] : previous_pv[0];
+            result.score = score;
+            result.stats.depth = depth;
+
+            if (thread_id == 0 && limits.on_iteration)
+            {
+                SearchResult progress = result;
+                progress.stats = stats;
+                progress.stats.depth = depth;
+                progress.stats.nodes = nodes;
+                progress.stats.seconds = elapsed();
+                progress.stats.nps = progress.stats.seconds > 0 ? static_cast<uint64_t>(nodes / progress.stats.seconds) : 0;
+                progress.stats.hashfull = shared.tt.hashfull();
+                limits.on_iteration(progress);
+            }
+
+            // A mate found is final, and past the soft limit the next iteration would rarely finish in time
+            if (score > MATE_BOUND || score < -MATE_BOUND)
+                break;
+            int64_t soft_time_ms = limits.soft_time_ms ? limits.soft_time_ms : limits.time_ms / 2;
+            if (thread_id == 0 && limits.time_ms && !pondering() && budget_elapsed_ms() >= soft_time_ms)
+                break;
+        }
+
+        stats.depth = result.stats.depth;
+        result.stats = stats;
+        result.stats.nodes = nodes;
+        result.stats.seconds = elapsed();
+        result.stats.nps = result.stats.seconds > 0 ? static_cast<uint64_t>(nodes / result.stats.seconds) : 0;
+        return result;
+    }
+}
+
+SearchResult search(Board& board, const SearchLimits& limits)
+{
+    return search(board, limits, TT);
+}
+
+SearchResult search(Board& board, const SearchLimits& limits, TranspositionTable& tt)
+{
+    INSTRUMENT_SCOPE(Probe::Search);
+    if (tt.empty())
+        tt.resize(DEFAULT_HASH_MB);
+    tt.new_search();
+
+    SharedSearch shared(tt);
+    int threads = std::max(1, limits.threads);
+    std::vector<Board> boards(threads - 1, board);
+    std::vector<SearchResult> results(threads);
+
+    std::vector<std::thread> helpers;
+    for (int i = 1; i < threads; ++i)
+    {
+        helpers.emplace_back([&, i]()
+        {
+            Searcher searcher(boards[i - 1], limits, shared, i);
+            results[i] = searcher.run();
+        });
+    }
+
+    Searcher main_searcher(board, limits, shared, 0);
+    results[0] = main_searcher.run();
+    shared.stop = true;
+    for (auto& helper : helpers)
+        helper.join();
+
+    // Take the deepest completed iteration, the higher score breaking ties
+    SearchResult best = results[0];
+    for (int i = 1; i < threads; ++i)
+    {
+        const SearchResult& result = results[i];
+        if (result.best_move != NULL_MOVE &&
+            (result.stats.depth > best.stats.depth ||
+             (result.stats.depth == best.stats.depth && result.score > best.score)))
+        {
+            best.best_move = result.best_move;
+            best.score = result.score;
+            best.pv = result.pv;
+            best.stats.depth = result.stats.depth;
+        }
+    }
+
+    // Counters add up over all threads
+    for (int i = 1; i < threads; ++i)
+    {
+        best.stats.nodes += results[i].stats.nodes;
+        best.stats.tt_probes += results[i].stats.tt_probes;
+        best.stats.tt_hits += results[i].stats.tt_hits;
+        best.stats.tt_stores += results[i].stats.tt_stores;
+        best.stats.tt_collisions += results[i].stats.tt_collisions;
+        best.stats.beta_cutoffs += results[i].stats.beta_cutoffs;
+        best.stats.first_move_cutoffs += results[i].stats.first_move_cutoffs;
+        best.stats.tb_hits += results[i].stats.tb_hits;
+    }
+    best.stats.seconds = std::chrono::duration<double>(Clock::now() - shared.start).count();
+    best.stats.nps = best.stats.seconds > 0 ? static_cast<uint64_t>(best.stats.nodes / best.stats.seconds) : 0;
+    best.stats.hashfull = tt.hashfull();
+    return best;
+}
+
+namespace
+{
+    const char* BENCH_POSITIONS[] =
+    {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    };
+}
+
+int feature_bench_command(const std::vector<std::string>& args)
+{
+    int64_t time_ms = args.size() > 1 ? std::atoi(args[1].c_str()) : 1000;
+
+    struct Variant
+    {
+        const char* name;
+        bool SearchFeatures::*feature;  // Switched off, or nothing for the first two rows
+    };
+    const Variant variants[] =
+    {
+        {"all on", nullptr},
+        {"no null move", &SearchFeatures::null_move},
+        {"no LMR", &SearchFeatures::late_move_reductions},
+        {"no reverse futility", &SearchFeatures::reverse_futility},
+        {"no futility", &SearchFeatures::futility},
+        {"no aspiration", &SearchFeatures::aspiration},
+        {"all off", nullptr},
+    };
+
+    std::cout << "Average depth in " << time_ms << " ms over " << std::size(BENCH_POSITIONS) << " positions\n";
+    for (const Variant& variant : variants)
+    {
+        SearchLimits limits;
+        limits.time_ms = time_ms;
+        if (variant.feature)
+            limits.features.*variant.feature = false;
+        else if (variant.name != variants[0].name)
+            limits.features = SearchFeatures{false, false, false, false, false};
+
+        double depth = 0;
+        uint64_t nodes = 0;
+        for (const char* fen : BENCH_POSITIONS)
+        {
+            Board board(false);
+            board.from_fen(fen);
+            TT.clear();
+            SearchResult result = search(board, limits);
+            depth += static_cast<double>(result.stats.depth) / std::size(BENCH_POSITIONS);
+            nodes += result.stats.nodes;
+        }
+        std::cout << std::left << std::setw(22) << variant.name << std::right << std::fixed << std::setprecision(2)
+                  << "depth " << depth << ", " << nodes << " nodes\n";
+    }
+    return 0;
+}
+
+int smp_bench_command(const std::vector<std::string>& args)
+{
+    const auto& positions = BENCH_POSITIONS;
+    int depth = args.size() > 1 ? std::atoi(args[1].c_str()) : 8;
+    int max_threads = args.size() > 2 ? std::atoi(args[2].c_str())
+                                      : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+    double base_seconds = 0;
+    std::cout << "Time to depth " << depth << " over " << std::size(positions) << " positions\n";
+    for (int threads = 1; threads <= max_threads; threads = threads < max_threads ? std::min(threads * 2, max_threads) : threads + 1)
+    {
+        SearchLimits limits;
+        limits.depth = depth;
+        limits.threads = threads;
+
+        uint64_t nodes = 0;
+        double seconds = 0;
+        SearchStats ordering;
+        double branching = 0;
+        for (const char* fen : positions)
+        {
+            Board board(false);
+            board.from_fen(fen);
+            TT.clear();
+            SearchResult result = search(board, limits);
+            nodes += result.stats.nodes;
+            seconds += result.stats.seconds;
+            ordering.beta_cutoffs += result.stats.beta_cutoffs;
+            ordering.first_move_cutoffs += result.stats.first_move_cutoffs;
+            branching += result.stats.branching_factor / std::size(positions);
+        }
+        if (threads == 1)
+            base_seconds = seconds;
+
+        std::cout << std::setw(3) << threads << " threads: " << std::fixed << std::setprecision(3)
+                  << seconds << " s, " << static_cast<uint64_t>(seconds > 0 ? nodes / seconds : 0)
+                  << " nodes/s, speedup " << std::setprecision(2) << (seconds > 0 ? base_seconds / seconds : 0) << "x"
+                  << ", first-move cutoffs " << std::setprecision(1) << ordering.first_move_cutoff_rate() * 100
+                  << "%, branching factor " << std::setprecision(2) << branching << "\n";
+    }
+    return 0;
+}
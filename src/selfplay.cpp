@@ -0,0 +1,186 @@
+// selfplay.cpp
+#include "selfplay.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <thread>
+#include "movegen.hpp"
+#include "tablebase.hpp"
+#include "tt.hpp"
+#include "validation.hpp"
+
+namespace
+{
+    // SplitMix64 step, so neighbouring game indices get unrelated seeds
+    uint64_t mix_seed(uint64_t seed, uint64_t index)
+    {
+        uint64_t z = seed + (index + 1) * 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    const char* result_string(int result)
+    {
+        return result > 0 ? "1-0" : result < 0 ? "0-1" : "1/2-1/2";
+    }
+}
+
+GameRecord play_selfplay_game(const SelfPlayConfig& config, int index, TranspositionTable& tt)
+{
+    std::mt19937_64 generator(mix_seed(config.seed, index));
+    tt.clear();
+    GameRecord record;
+    record.index = index;
+
+    Board board(false);
+    board.initialize();
+    MoveList moves;
+    while (true)
+    {
+        moves.clear();
+        generate_legal_moves(board, moves);
+        if (moves.empty())
+        {
+            bool mated = board.is_in_check(board.get_turn());
+            record.result = mated ? -board.get_turn() : 0;
+            record.reason = mated ? "checkmate" : "stalemate";
+            break;
+        }
+        if (board.get_fifty_move_counter() >= 100)
+        {
+            record.reason = "fifty-move";
+            break;
+        }
+        if (board.is_threefold_repetition())
+        {
+            record.reason = "repetition";
+            break;
+        }
+        if (is_insufficient_material(board))
+        {
+            record.reason = "material";
+            break;
+        }
+        TBResult outcome;
+        if (TABLEBASES.probe(board.get_position(), outcome))
+        {
+            record.result = outcome.wdl * board.get_turn();
+            record.reason = "tablebase";
+            break;
+        }
+        if (record.plies >= config.max_plies)
+        {
+            record.reason = "max-plies";
+            break;
+        }
+
+        Move move;
+        if (config.policy == SelfPlayPolicy::Random || record.plies < config.random_opening_plies)
+            move = moves[generator() % moves.size()];
+        else
+            move = search(board, config.limits, tt).best_move;
+        board.make_move(move);
+        ++record.plies;
+    }
+    return record;
+}
+
+int selfplay_command(const std::vector<std::string>& args)
+{
+    SelfPlayConfig config;
+    config.threads = std::max(1u, std::thread::hardware_concurrency());
+    config.limits.depth = 4;
+    for (size_t i = 1; i < args.size(); ++i)
+    {
+        bool has_value = i + 1 < args.size();
+        if (args[i] == "-t" && has_value)
+            config.threads = std::max(1, std::atoi(args[++i].c_str()));
+        else if (args[i] == "-p" && has_value)
+            config.policy = args[++i] == "random" ? SelfPlayPolicy::Random : SelfPlayPolicy::Engine;
+        else if (args[i] == "-d" && has_value)
+            config.limits.depth = std::max(1, std::atoi(args[++i].c_str()));
+        else if (args[i] == "-n" && has_value)
+        {
+            config.limits.nodes = std::strtoull(args[++i].c_str(), nullptr, 10);
+            config.limits.depth = MAX_PLY - 1;
+        }
+        else if (args[i] == "-s" && has_value)
+            config.seed = std::strtoull(args[++i].c_str(), nullptr, 10);
+        else if (args[i] == "-o" && has_value)
+            config.log_path = args[++i];
+        else if (args[i] == "-e" && has_value)
+            TABLEBASES.load(args[++i]);
+        else
+            config.games = std::max(1, std::atoi(args[i].c_str()));
+    }
+
+    std::ofstream log;
+    if (!config.log_path.empty())
+        log.open(config.log_path);
+
+    std::mutex results_mutex;
+    std::map<std::string, int> reasons;
+    int wins[3] = {0, 0, 0}; // Black, draw, white
+    uint64_t total_plies = 0;
+
+    // The log lists games by index whatever order they finish in, so runs
+    // with the same seed give identical logs for any thread count
+    std::vector<GameRecord> finished(config.games);
+    std::vector<bool> done(config.games, false);
+    int next_to_log = 0;
+
+    std::atomic<int> next_game{0};
+    auto start = std::chrono::steady_clock::now();
+    auto worker = [&]()
+    {
+        // A table per worker, cleared every game, so no game sees another's entries
+        TranspositionTable tt;
+        if (config.policy == SelfPlayPolicy::Engine)
+            tt.resize(DEFAULT_HASH_MB);
+
+        int index;
+        while ((index = next_game.fetch_add(1)) < config.games)
+        {
+            GameRecord record = play_selfplay_game(config, index, tt);
+
+            std::lock_guard<std::mutex> lock(results_mutex);
+            ++wins[record.result + 1];
+            ++reasons[record.reason];
+            total_plies += record.plies;
+            finished[index] = record;
+            done[index] = true;
+            for (; next_to_log < config.games && done[next_to_log]; ++next_to_log)
+            {
+                const GameRecord& logged = finished[next_to_log];
+                if (log.is_open())
+                    log << logged.index << ' ' << result_string(logged.result) << ' ' << logged.plies << ' ' << logged.reason << '\n';
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 1; i < config.threads; ++i)
+        workers.emplace_back(worker);
+    worker();
+    for (auto& thread : workers)
+        thread.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << config.games << " games (" << (config.policy == SelfPlayPolicy::Random ? "random" : "engine")
+              << " policy, " << config.threads << " threads, seed " << config.seed << ")\n"
+              << "White wins " << wins[2] << ", draws " << wins[1] << ", black wins " << wins[0] << "\n";
+    for (const auto& [reason, count] : reasons)
+        std::cout << "  " << std::left << std::setw(11) << reason << std::right << count << "\n";
+    std::cout << std::fixed << std::setprecision(3) << seconds << " s, "
+              << std::setprecision(1) << (seconds > 0 ? config.games / seconds : 0) << " games/s, "
+              << static_cast<uint64_t>(seconds > 0 ? total_plies / seconds : 0) << " plies/s, "
+              << std::setprecision(1) << static_cast<double>(total_plies) / config.games << " plies/game\n";
+    return 0;
+}
@@ -0,0 +1,978 @@
+// tablebase.cpp
+#include "tablebase.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "movegen.hpp"
+#include "search.hpp"
+
+Tablebases TABLEBASES;
+
+namespace
+{
+    // Stored values: 0 draw, 1..127 win in that many moves, 128 + n mated in n moves
+    constexpr uint8_t TB_DRAW = 0;
+    constexpr uint8_t TB_LOSS = 128;
+    constexpr uint8_t TB_INVALID = 254;     // Generation only: impossible placement
+    constexpr uint8_t TB_UNKNOWN = 255;     // Generation only: not resolved yet
+
+    // Distances are in plies: odd ones are wins for the side to move, even ones losses
+    uint8_t encode_dtm(int dtm)
+    {
+        return static_cast<uint8_t>(dtm & 1 ? (dtm + 1) / 2 : TB_LOSS + dtm / 2);
+    }
+
+    int decode_dtm(uint8_t value)
+    {
+        return value < TB_LOSS ? value * 2 - 1 : (value - TB_LOSS) * 2;
+    }
+
+    const char TB_MAGIC[8] = {'C', 'H', 'E', 'S', 'S', 'T', 'B', '\0'};
+    constexpr uint32_t TB_VERSION = 1;
+    const char* TB_EXTENSION = ".ctb";
+
+    // File header, followed by one value per index
+    struct TableHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t max_dtm;
+        uint64_t entries;
+        char name[16];
+        uint8_t reserved[24];
+    };
+
+    static_assert(sizeof(TableHeader) == 64, "Table values must start 64-byte aligned");
+
+    const char PIECE_LETTERS[] = "PNBRQ";
+
+    // Non-king pieces per color, by piece type - 1 (pawn ... queen)
+    struct Material
+    {
+        int count[2][5] = {};
+
+        int extras(int color) const
+        {
+            int total = 0;
+            for (int type = 0; type < 5; ++type)
+                total += count[color][type];
+            return total;
+        }
+
+        int pawns() const { return count[WHITE][0] + count[BLACK][0]; }
+
+        // At most two of a kind per side fit in four pieces, so base 3 is enough
+        int code() const
+        {
+            int code = 0;
+            for (int color = 0; color < 2; ++color)
+            {
+                for (int type = 0; type < 5; ++type)
+                    code = code * 3 + count[color][type];
+            }
+            return code;
+        }
+
+        // More pieces first, then the strongest ones; tables keep the stronger side white
+        int strength(int color) const
+        {
+            int value = extras(color);
+            for (int type = 4; type >= 0; --type)
+            {
+                for (int i = 0; i < count[color][type]; ++i)
+                    value = value * 10 + type + 1;
+            }
+            for (int i = extras(color); i < 2; ++i)
+                value *= 10;
+            return value;
+        }
+
+        std::string name() const
+        {
+            std::string name = "K";
+            for (int color = 0; color < 2; ++color)
+            {
+                for (int type = 4; type >= 0; --type)
+                    name.append(count[color][type], PIECE_LETTERS[type]);
+                if (color == WHITE)
+                    name += "vK";
+            }
+            return name;
+        }
+    };
+
+    constexpr int MATERIAL_CODES = 59049;   // 3^10
+
+    Material material_of(const Position& pos)
+    {
+        Material material;
+        for (int type = PAWN_WHITE; type <= QUEEN_WHITE; ++type)
+        {
+            material.count[WHITE][type - 1] = pop_count(pos.pieces_of(type));
+            material.count[BLACK][type - 1] = pop_count(pos.pieces_of(-type));
+        }
+        return material;
+    }
+
+    bool parse_material(const std::string& name, Material& material)
+    {
+        material = Material{};
+        size_t split = name.find("vK");
+        if (name.size() < 3 || name[0] != 'K' || split == std::string::npos)
+            return false;
+        for (size_t i = 1; i < name.size(); ++i)
+        {
+            if (i >= split && i < split + 2)
+                continue;
+            const char* letter = std::strchr(PIECE_LETTERS, name[i]);
+            if (!letter || !*letter)
+                return false;
+            ++material.count[i < split ? WHITE : BLACK][letter - PIECE_LETTERS];
+        }
+        return material.extras(WHITE) + material.extras(BLACK) + 2 <= TB_MAX_PIECES &&
+               material.extras(WHITE) + material.extras(BLACK) > 0 &&
+               material.strength(WHITE) >= material.strength(BLACK);
+    }
+
+    // The white king is moved by symmetry into the a1-d1-d4 triangle without
+    // pawns, or onto files a-d with them; its slot replaces its square in the index
+    struct KingSlots
+    {
+        int slot[2][64];
+        int square[2][32];
+        int count[2] = {0, 0};
+
+        KingSlots()
+        {
+            for (int square = 0; square < 64; ++square)
+            {
+                int file = square_col(square), rank = square_rank(square);
+                slot[0][square] = slot[1][square] = -1;
+                if (file <= 3 && rank <= file)
+                {
+                    this->square[0][count[0]] = square;
+                    slot[0][square] = count[0]++;
+                }
+                if (file <= 3)
+                {
+                    this->square[1][count[1]] = square;
+                    slot[1][square] = count[1]++;
+                }
+            }
+        }
+    };
+
+    const KingSlots KING_SLOTS;
+
+    uint64_t table_entries(const Material& material)
+    {
+        uint64_t entries = 2 * KING_SLOTS.count[material.pawns() > 0] * 64;
+        for (int i = 0; i < material.extras(WHITE) + material.extras(BLACK); ++i)
+            entries *= 64;
+        return entries;
+    }
+
+    // Where a covered position lives: its table and index
+    struct TableKey
+    {
+        int code;
+        uint64_t index;
+    };
+
+    int transpose_square(int square)
+    {
+        return square_col(square) * 8 + square_rank(square);
+    }
+
+    // Index layout: side to move, white king slot, black king, then the white
+    // and black pieces from the strongest down, 64 squares each. Symmetric
+    // positions share one index, so every position has exactly one.
+    bool table_key(const Position& pos, TableKey& key)
+    {
+        if (pos.castling || pos.en_passant != NO_SQUARE || pop_count(pos.occupied) > TB_MAX_PIECES)
+            return false;
+
+        Material material = material_of(pos);
+        int strong = material.strength(BLACK) > material.strength(WHITE) ? -1 : 1;
+        if (strong == -1)
+            std::swap(material.count[WHITE], material.count[BLACK]);
+
+        int squares[TB_MAX_PIECES];
+        int kinds[TB_MAX_PIECES];
+        int count = 0;
+        kinds[count] = KING_WHITE;
+        squares[count++] = pos.king_square(strong);
+        kinds[count] = KING_BLACK;
+        squares[count++] = pos.king_square(-strong);
+        for (int side : {strong, -strong})
+        {
+            for (int type = QUEEN_WHITE; type >= PAWN_WHITE; --type)
+            {
+                Bitboard pieces = pos.pieces_of(type * side);
+                while (pieces)
+                {
+                    kinds[count] = type * side;
+                    squares[count++] = pop_lsb(pieces);
+                }
+            }
+        }
+
+        // Colors swap by mirroring the ranks, then the white king goes home
+        bool pawns = material.pawns() > 0;
+        int flip = strong == -1 ? 56 : 0;
+        if (square_col(squares[0]) > 3)
+            flip ^= 7;
+        if (!pawns && square_rank(squares[0] ^ flip) > 3)
+            flip ^= 56;
+
+        uint64_t side = pos.turn == strong ? 0 : 1;
+        auto index_of = [&](bool transpose)
+        {
+            int mapped[TB_MAX_PIECES];
+            for (int i = 0; i < count; ++i)
+                mapped[i] = transpose ? transpose_square(squares[i] ^ flip) : squares[i] ^ flip;
+            // Twin pieces in square order
+            for (int i = 2; i + 1 < count; ++i)
+            {
+                if (kinds[i] == kinds[i + 1] && mapped[i] > mapped[i + 1])
+                    std::swap(mapped[i], mapped[i + 1]);
+            }
+            uint64_t index = side * KING_SLOTS.count[pawns] + KING_SLOTS.slot[pawns][mapped[0]];
+            for (int i = 1; i < count; ++i)
+                index = index * 64 + mapped[i];
+            return index;
+        };
+
+        // Off the diagonal the triangle fixes the frame; on it, both frames fit and the smaller index wins
+        int home = squares[0] ^ flip;
+        if (pawns || square_rank(home) < square_col(home))
+            key.index = index_of(false);
+        else if (square_rank(home) > square_col(home))
+            key.index = index_of(true);
+        else
+            key.index = std::min(index_of(false), index_of(true));
+        key.code = material.code();
+        return true;
+    }
+
+    // Inverse of table_key; false for placements no game can reach
+    bool decode_position(const Material& material, const int* pieces, uint64_t index, Position& pos)
+    {
+        int count = 2 + material.extras(WHITE) + material.extras(BLACK);
+        bool pawns = material.pawns() > 0;
+        int squares[TB_MAX_PIECES];
+        for (int i = count - 1; i > 0; --i)
+        {
+            squares[i] = index % 64;
+            index /= 64;
+        }
+        squares[0] = KING_SLOTS.square[pawns][index % KING_SLOTS.count[pawns]];
+        int turn = index / KING_SLOTS.count[pawns] == 0 ? 1 : -1;
+
+        Bitboard used = 0;
+        for (int i = 0; i < count; ++i)
+        {
+            if (used & square_bb(squares[i]))
+                return false;
+            used |= square_bb(squares[i]);
+            if (piece_type(pieces[i]) == PAWN_WHITE && (square_rank(squares[i]) == 0 || square_rank(squares[i]) == 7))
+                return false;
+        }
+
+        pos.clear();
+        for (int i = 0; i < count; ++i)
+            pos.add_piece(pieces[i], squares[i]);
+        if (turn == -1)
+        {
+            pos.turn = -1;
+            pos.key ^= ZOBRIST.side;
+        }
+        // The side that just moved cannot have left its king in check
+        return !is_square_attacked(pos, pos.king_square(-turn), turn);
+    }
+
+    // Spreads [0, count) over the threads in blocks; work(begin, end, thread)
+    template <typename Work>
+    void parallel_for(uint64_t count, int threads, Work work)
+    {
+        constexpr uint64_t BLOCK = 1 << 14;
+        std::atomic<uint64_t> next{0};
+        auto worker = [&](int thread)
+        {
+            uint64_t begin;
+            while ((begin = next.fetch_add(BLOCK)) < count)
+                work(begin, std::min(count, begin + BLOCK), thread);
+        };
+        std::vector<std::thread> workers;
+        for (int i = 1; i < threads; ++i)
+            workers.emplace_back(worker, i);
+        worker(0);
+        for (auto& thread : workers)
+            thread.join();
+    }
+
+    // Retrograde analysis of one table. Iteration n resolves the positions
+    // whose distance to mate is n plies: wins with a move into a loss in n - 1,
+    // losses whose every move reaches a win of at most n - 1. Smaller tables
+    // reached by captures and promotions are probed from TABLEBASES.
+    class Generator
+    {
+        public:
+            Generator(const Material& material, int threads)
+                : material(material), code(material.code()), threads(threads),
+                  values(table_entries(material), TB_UNKNOWN)
+            {
+                int count = 2;
+                pieces[0] = KING_WHITE;
+                pieces[1] = KING_BLACK;
+                for (int sign : {1, -1})
+                {
+                    for (int type = 4; type >= 0; --type)
+                    {
+                        for (int i = 0; i < material.count[sign == 1 ? WHITE : BLACK][type]; ++i)
+                            pieces[count++] = (type + 1) * sign;
+                    }
+                }
+            }
+
+            int run();
+            const std::vector<uint8_t>& result() const { return values; }
+
+        private:
+            uint8_t position_value(Board& board, int visible) const;
+            uint8_t node_value(Board& board, int visible) const;
+
+            Material material;
+            int code;
+            int threads;
+            int pieces[TB_MAX_PIECES];
+            std::vector<uint8_t> values;
+    };
+
+    // Value of the position on the board if it is known within visible plies
+    uint8_t Generator::position_value(Board& board, int visible) const
+    {
+        if (visible < 0)
+            return TB_UNKNOWN;
+        const Position& pos = board.get_position();
+        if (pop_count(pos.occupied) == 2)
+            return TB_DRAW;
+
+        // En passant positions have no index: evaluate their moves instead
+        TableKey key;
+        if (!table_key(pos, key))
+            return node_value(board, visible);
+
+        uint8_t value;
+        if (key.code == code)
+            value = values[key.index];
+        else
+        {
+            TBResult result;
+            if (!TABLEBASES.probe(pos, result))
+                return TB_UNKNOWN;
+            value = result.wdl == 0 ? TB_DRAW : encode_dtm(result.dtm);
+        }
+        if (value == TB_DRAW || value == TB_UNKNOWN)
+            return value;
+        return decode_dtm(value) <= visible ? value : TB_UNKNOWN;
+    }
+
+    // Value from the moves, using what is known of the successors within visible - 1 plies
+    uint8_t Generator::node_value(Board& board, int visible) const
+    {
+        MoveList moves;
+        generate_legal_moves(board, moves);
+        if (moves.empty())
+            return board.is_in_check(board.get_turn()) ? encode_dtm(0) : TB_DRAW;
+
+        int quickest_win = INT_MAX;
+        int longest_loss = -1;
+        bool unknown = false, draw = false;
+        for (Move move : moves)
+        {
+            board.make_move(move);
+            uint8_t value = position_value(board, visible - 1);
+            board.unmake_move();
+
+            if (value == TB_UNKNOWN)
+                unknown = true;
+            else if (value == TB_DRAW)
+                draw = true;
+            else if (value >= TB_LOSS)
+                quickest_win = std::min(quickest_win, decode_dtm(value) + 1);
+            else
+                longest_loss = std::max(longest_loss, decode_dtm(value) + 1);
+        }
+        if (quickest_win != INT_MAX)
+            return encode_dtm(quickest_win);
+        if (unknown)
+            return TB_UNKNOWN;
+        return draw ? TB_DRAW : encode_dtm(longest_loss);
+    }
+
+    // Positions one move earlier within the table: the side that just moved
+    // steps back. Captures and promotions came from other tables.
+    template <typename Visit>
+    void for_each_predecessor(const Position& pos, Visit visit)
+    {
+        int mover = -pos.turn;
+        Bitboard empty = ~pos.occupied;
+        Bitboard pieces = pos.color_pieces(mover);
+        while (pieces)
+        {
+            int square = pop_lsb(pieces);
+            Bitboard origins;
+            switch (piece_type(pos.piece_on(square)))
+            {
+                case PAWN_WHITE:
+                {
+                    // One square back, never from the own back rank, or two from the start rank
+                    int back = mover == 1 ? -8 : 8;
+                    int relative_rank = mover == 1 ? square_rank(square) : 7 - square_rank(square);
+                    origins = 0;
+                    if (relative_rank > 1 && (empty & square_bb(square + back)))
+                    {
+                        origins |= square_bb(square + back);
+                        if (relative_rank == 3 && (empty & square_bb(square + 2 * back)))
+                            origins |= square_bb(square + 2 * back);
+                    }
+                    break;
+                }
+                case KNIGHT_WHITE: origins = knight_attacks(square) & empty; break;
+                case BISHOP_WHITE: origins = bishop_attacks(square, pos.occupied) & empty; break;
+                case ROOK_WHITE: origins = rook_attacks(square, pos.occupied) & empty; break;
+                case QUEEN_WHITE: origins = queen_attacks(square, pos.occupied) & empty; break;
+                default: origins = king_attacks(square) & empty; break;
+            }
+            while (origins)
+            {
+                Position previous = pos;
+                previous.relocate_piece(square, pop_lsb(origins));
+                previous.turn = static_cast<int8_t>(mover);
+                visit(previous);
+            }
+        }
+    }
+
+    // Returns the longest mate found, in plies
+    int Generator::run()
+    {
+        // Start: impossible and duplicate placements, mates and stalemates. Moves into
+        // smaller tables have fixed values, so when they become visible is known now:
+        // a position is looked at again in the iterations they can decide it.
+        std::vector<std::vector<std::pair<int, uint64_t>>> scheduled(threads);
+        std::vector<std::vector<uint64_t>> en_passant(threads);
+        parallel_for(values.size(), threads, [&](uint64_t begin, uint64_t end, int thread)
+        {
+            Board board(false);
+            Position pos;
+            MoveList moves;
+            TableKey key;
+            for (uint64_t index = begin; index < end; ++index)
+            {
+                if (!decode_position(material, pieces, index, pos) || (table_key(pos, key), key.index != index))
+                {
+                    values[index] = TB_INVALID;
+                    continue;
+                }
+                board.set_position(pos);
+                moves.clear();
+                generate_legal_moves(board, moves);
+                if (moves.empty())
+                {
+                    values[index] = board.is_in_check(pos.turn) ? encode_dtm(0) : TB_DRAW;
+                    continue;
+                }
+
+                int quickest_win = INT_MAX, longest_loss = -1;
+                bool has_en_passant = false;
+                for (Move move : moves)
+                {
+                    board.make_move(move);
+                    const Position& child = board.get_position();
+                    TBResult result;
+                    if (child.en_passant != NO_SQUARE)
+                        has_en_passant = true;
+                    else if ((move.is_capture() || move.is_promotion()) && TABLEBASES.probe(child, result))
+                    {
+                        if (result.wdl < 0)
+                            quickest_win = std::min(quickest_win, result.dtm + 1);
+                        else if (result.wdl > 0)
+                            longest_loss = std::max(longest_loss, result.dtm + 1);
+                    }
+                    board.unmake_move();
+                }
+                if (quickest_win != INT_MAX)
+                    scheduled[thread].emplace_back(quickest_win, index);
+                if (longest_loss >= 0)
+                    scheduled[thread].emplace_back(longest_loss, index);
+                if (has_en_passant)
+                    en_passant[thread].push_back(index);
+            }
+        });
+
+        // Positions after a double push that allows en passant have no index, so
+        // the ones leading there are looked at in every iteration
+        std::vector<std::vector<uint64_t>> by_iteration;
+        int last_scheduled = 1;
+        for (const auto& list : scheduled)
+        {
+            for (const auto& [iteration, index] : list)
+            {
+                if (iteration >= static_cast<int>(by_iteration.size()))
+                    by_iteration.resize(iteration + 1);
+                by_iteration[iteration].push_back(index);
+                last_scheduled = std::max(last_scheduled, iteration);
+            }
+        }
+        scheduled.clear();
+        std::vector<uint64_t> always;
+        for (const auto& list : en_passant)
+            always.insert(always.end(), list.begin(), list.end());
+        if (!always.empty())
+            last_scheduled = std::max(last_scheduled, TABLEBASES.max_dtm() + 2);
+
+        // Each iteration only reads values of earlier ones, so updates wait for the join
+        std::unique_ptr<std::atomic<uint8_t>[]> dirty(new std::atomic<uint8_t>[values.size()]);
+        for (uint64_t index = 0; index < values.size(); ++index)
+            dirty[index].store(1, std::memory_order_relaxed);
+        std::vector<std::vector<std::pair<uint64_t, uint8_t>>> updates(threads);
+        std::vector<uint64_t> resolved;
+        for (int n = 1; ; ++n)
+        {
+            parallel_for(values.size(), threads, [&](uint64_t begin, uint64_t end, int thread)
+            {
+                Board board(false);
+                Position pos;
+                for (uint64_t index = begin; index < end; ++index)
+                {
+                    if (values[index] != TB_UNKNOWN || !dirty[index].load(std::memory_order_relaxed))
+                        continue;
+                    decode_position(material, pieces, index, pos);
+                    board.set_position(pos);
+                    uint8_t value = node_value(board, n);
+                    if (value != TB_UNKNOWN)
+                        updates[thread].emplace_back(index, value);
+                }
+            });
+
+            resolved.clear();
+            for (auto& list : updates)
+            {
+                for (const auto& [index, value] : list)
+                {
+                    values[index] = value;
+                    resolved.push_back(index);
+                }
+                list.clear();
+            }
+            if (resolved.empty() && n >= last_scheduled)
+                break;
+
+            // Next to look at: what can move into a position just resolved
+            for (uint64_t index = 0; index < values.size(); ++index)
+                dirty[index].store(0, std::memory_order_relaxed);
+            parallel_for(resolved.size(), threads, [&](uint64_t begin, uint64_t end, int)
+            {
+                Position pos;
+                TableKey key;
+                for (uint64_t i = begin; i < end; ++i)
+                {
+                    decode_position(material, pieces, resolved[i], pos);
+                    for_each_predecessor(pos, [&](const Position& previous)
+                    {
+                        table_key(previous, key);
+                        dirty[key.index].store(1, std::memory_order_relaxed);
+                    });
+                }
+            });
+            if (n + 1 < static_cast<int>(by_iteration.size()))
+            {
+                for (uint64_t index : by_iteration[n + 1])
+                    dirty[index].store(1, std::memory_order_relaxed);
+            }
+            for (uint64_t index : always)
+                dirty[index].store(1, std::memory_order_relaxed);
+        }
+
+        // What never resolved is a draw; impossible placements are never probed
+        int longest = 0;
+        for (uint8_t& value : values)
+        {
+            if (value == TB_UNKNOWN || value == TB_INVALID)
+                value = TB_DRAW;
+            else if (value != TB_DRAW)
+                longest = std::max(longest, decode_dtm(value));
+        }
+        return longest;
+    }
+
+    // Tables a capture or promotion leads to, which must exist first
+    std::vector<std::string> dependencies(const Material& material)
+    {
+        std::vector<std::string> names;
+        auto add = [&](Material child)
+        {
+            if (child.extras(WHITE) + child.extras(BLACK) == 0)
+                return;
+            if (child.strength(BLACK) > child.strength(WHITE))
+                std::swap(child.count[WHITE], child.count[BLACK]);
+            if (std::find(names.begin(), names.end(), child.name()) == names.end())
+                names.push_back(child.name());
+        };
+        for (int color = 0; color < 2; ++color)
+        {
+            for (int type = 0; type < 5; ++type)
+            {
+                if (material.count[color][type] == 0)
+                    continue;
+                Material child = material;
+                --child.count[color][type];
+                add(child);
+                for (int promotion = 1; type == 0 && promotion < 5; ++promotion)
+                {
+                    Material promoted = child;
+                    ++promoted.count[color][promotion];
+                    add(promoted);
+                }
+            }
+        }
+        return names;
+    }
+
+    // Every 3 and 4 piece signature, ordered so dependencies come first
+    std::vector<Material> all_materials()
+    {
+        std::vector<Material> materials;
+        for (int code = 1; code < MATERIAL_CODES; ++code)
+        {
+            Material material;
+            for (int i = 0, digits = code; i < 10; ++i, digits /= 3)
+                material.count[i / 5][i % 5] = digits % 3;
+            if (material.extras(WHITE) + material.extras(BLACK) > 0 &&
+                material.extras(WHITE) + material.extras(BLACK) + 2 <= TB_MAX_PIECES &&
+                material.strength(WHITE) >= material.strength(BLACK))
+                materials.push_back(material);
+        }
+        std::stable_sort(materials.begin(), materials.end(), [](const Material& a, const Material& b)
+        {
+            int a_pieces = a.extras(WHITE) + a.extras(BLACK), b_pieces = b.extras(WHITE) + b.extras(BLACK);
+            return a_pieces != b_pieces ? a_pieces < b_pieces : a.pawns() < b.pawns();
+        });
+        return materials;
+    }
+
+    bool write_table(const std::string& path, const Material& material, int max_dtm, const std::vector<uint8_t>& values)
+    {
+        TableHeader header = {};
+        std::memcpy(header.magic, TB_MAGIC, sizeof(header.magic));
+        header.version = TB_VERSION;
+        header.max_dtm = max_dtm;
+        header.entries = values.size();
+        std::strncpy(header.name, material.name().c_str(), sizeof(header.name) - 1);
+
+        std::ofstream file(path, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(values.data()), values.size());
+        return static_cast<bool>(file);
+    }
+
+    std::string describe(const TBResult& result)
+    {
+        if (result.wdl == 0)
+            return "draw";
+        return std::string(result.wdl > 0 ? "win" : "loss") + ", mate in " +
+               std::to_string((result.dtm + 1) / 2) + " (" + std::to_string(result.dtm) + " plies)";
+    }
+}
+
+Tablebases::~Tablebases()
+{
+    close();
+}
+
+int Tablebases::load(const std::string& directory)
+{
+    int loaded = 0;
+    std::error_code error;
+    for (const auto& file : std::filesystem::directory_iterator(directory, error))
+    {
+        if (file.path().extension() == TB_EXTENSION && map_table(file.path().string()))
+            ++loaded;
+    }
+    return loaded;
+}
+
+// Maps a table read-only and shared, so every process probing it uses the same pages
+bool Tablebases::map_table(const std::string& path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(TableHeader)))
+    {
+        ::close(fd);
+        return false;
+    }
+    void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+        return false;
+
+    TableHeader header;
+    std::memcpy(&header, mapping, sizeof(header));
+    header.name[sizeof(header.name) - 1] = '\0';
+    Material material;
+    if (std::memcmp(header.magic, TB_MAGIC, sizeof(TB_MAGIC)) != 0 || header.version != TB_VERSION ||
+        !parse_material(header.name, material) || header.entries != table_entries(material) ||
+        sizeof(TableHeader) + header.entries != static_cast<uint64_t>(info.st_size))
+    {
+        munmap(mapping, info.st_size);
+        return false;
+    }
+    madvise(mapping, info.st_size, MADV_RANDOM);
+
+    if (by_material.empty())
+        by_material.assign(MATERIAL_CODES, -1);
+    Table table;
+    table.name = header.name;
+    table.values = static_cast<const uint8_t*>(mapping) + sizeof(TableHeader);
+    table.entries = header.entries;
+    table.max_dtm = header.max_dtm;
+    table.mapping = mapping;
+    table.bytes = info.st_size;
+
+    // A table mapped again replaces the old mapping
+    int& slot = by_material[material.code()];
+    if (slot >= 0)
+    {
+        munmap(tables[slot].mapping, tables[slot].bytes);
+        tables[slot] = table;
+    }
+    else
+    {
+        slot = static_cast<int>(tables.size());
+        tables.push_back(table);
+    }
+    return true;
+}
+
+void Tablebases::close()
+{
+    for (Table& table : tables)
+        munmap(table.mapping, table.bytes);
+    tables.clear();
+    by_material.clear();
+}
+
+bool Tablebases::contains(const std::string& name) const
+{
+    Material material;
+    return parse_material(name, material) && !by_material.empty() && by_material[material.code()] >= 0;
+}
+
+int Tablebases::max_dtm() const
+{
+    int longest = 0;
+    for (const Table& table : tables)
+        longest = std::max(longest, table.max_dtm);
+    return longest;
+}
+
+bool Tablebases::probe(const Position& pos, TBResult& result) const
+{
+    if (tables.empty() || pos.castling || pos.en_passant != NO_SQUARE || pop_count(pos.occupied) > TB_MAX_PIECES)
+        return false;
+    if (pop_count(pos.occupied) == 2)
+    {
+        result = TBResult{};
+        return true;
+    }
+
+    TableKey key;
+    if (!table_key(pos, key) || by_material[key.code] < 0)
+        return false;
+    uint8_t value = tables[by_material[key.code]].values[key.index];
+    result.wdl = value == TB_DRAW ? 0 : value < TB_LOSS ? 1 : -1;
+    result.dtm = value == TB_DRAW ? 0 : decode_dtm(value);
+    return true;
+}
+
+Move tablebase_move(Board& board, TBResult& result)
+{
+    if (!TABLEBASES.probe(board.get_position(), result))
+        return NULL_MOVE;
+
+    MoveList moves;
+    generate_legal_moves(board, moves);
+    Move best = NULL_MOVE;
+    int best_rank = INT_MIN;
+    for (Move move : moves)
+    {
+        board.make_move(move);
+        TBResult child;
+        bool covered = TABLEBASES.probe(board.get_position(), child);
+        board.unmake_move();
+        if (!covered)
+            return NULL_MOVE;
+
+        // Quick wins above draws above long losses
+        int rank = child.wdl < 0 ? 1000 - child.dtm : child.wdl > 0 ? -1000 + child.dtm : 0;
+        if (rank > best_rank)
+        {
+            best_rank = rank;
+            best = move;
+        }
+    }
+    return best;
+}
+
+int tablebase_score(const TBResult& result, int ply)
+{
+    // Just below the mate band: ordered by distance, far above any evaluation,
+    // but not final the way a mate the search proved is. Above TB_BOUND, so
+    // the transposition table adjusts it for ply like a mate score
+    int score = MATE_BOUND - 1 - ply - result.dtm;
+    return result.wdl > 0 ? score : result.wdl < 0 ? -score : 0;
+}
+
+int tbgen_command(const std::vector<std::string>& args)
+{
+    if (args.size() < 2)
+    {
+        std::cerr << "Usage: tbgen <dir> [-t threads] [tables...]\n";
+        return 1;
+    }
+    std::string directory = args[1];
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<Material> materials;
+    for (size_t i = 2; i < args.size(); ++i)
+    {
+        Material material;
+        if (args[i] == "-t" && i + 1 < args.size())
+            threads = std::max(1, std::atoi(args[++i].c_str()));
+        else if (parse_material(args[i], material))
+            materials.push_back(material);
+        else
+        {
+            std::cerr << "Unknown table " << args[i] << " (expected e.g. KRvKN, stronger side first)\n";
+            return 1;
+        }
+    }
+
+    // Without a list, every missing table is built
+    std::filesystem::create_directories(directory);
+    TABLEBASES.load(directory);
+    bool all = materials.empty();
+    if (all)
+        materials = all_materials();
+
+    for (const Material& material : materials)
+    {
+        std::string name = material.name();
+        if (all && TABLEBASES.contains(name))
+            continue;
+        for (const std::string& dependency : dependencies(material))
+        {
+            if (!TABLEBASES.contains(dependency))
+            {
+                std::cerr << name << " needs " << dependency << " first\n";
+                return 1;
+            }
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        Generator generator(material, threads);
+        int longest = generator.run();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::string path = directory + "/" + name + TB_EXTENSION;
+        if (!write_table(path, material, longest, generator.result()) || !TABLEBASES.map_table(path))
+        {
+            std::cerr << "Could not write " << path << "\n";
+            return 1;
+        }
+
+        uint64_t outcomes[3] = {0, 0, 0}; // Losses, draws, wins for the side to move
+        for (uint8_t value : generator.result())
+            ++outcomes[value == TB_DRAW ? 1 : value < TB_LOSS ? 2 : 0];
+        std::cout << std::left << std::setw(8) << name << std::right << std::setw(10) << generator.result().size()
+                  << " positions, " << outcomes[2] << " won, " << outcomes[0] << " lost, longest mate "
+                  << longest << " plies, " << std::fixed << std::setprecision(1) << seconds << " s ("
+                  << threads << " threads)" << std::endl;
+    }
+    return 0;
+}
+
+int tbprobe_command(const std::vector<std::string>& args)
+{
+    if (args.size() < 2)
+    {
+        std::cerr << "Usage: tbprobe <dir> [fen]\n";
+        return 1;
+    }
+    if (TABLEBASES.load(args[1]) == 0)
+    {
+        std::cerr << "No tables in " << args[1] << "\n";
+        return 1;
+    }
+
+    Board board(false);
+    board.initialize();
+    std::string fen;
+    for (size_t i = 2; i < args.size(); ++i)
+        fen += (i > 2 ? " " : "") + args[i];
+    if (!fen.empty() && !board.from_fen(fen))
+    {
+        std::cerr << "Invalid FEN: " << fen << "\n";
+        return 1;
+    }
+
+    TBResult result;
+    if (!TABLEBASES.probe(board.get_position(), result))
+    {
+        std::cout << "Not covered by the loaded tables\n";
+        return 0;
+    }
+    std::cout << (board.get_turn() == 1 ? "White" : "Black") << " to move: " << describe(result) << "\n";
+
+    MoveList moves;
+    generate_legal_moves(board, moves);
+    for (Move move : moves)
+    {
+        board.make_move(move);
+        TBResult child;
+        bool covered = TABLEBASES.probe(board.get_position(), child);
+        board.unmake_move();
+        std::cout << "  " << std::left << std::setw(6) << move_to_string(move) << std::right;
+        if (!covered)
+            std::cout << "not covered\n";
+        else
+        {
+            // Seen from the mover: one ply further, other side's outcome
+            TBResult mover = {-child.wdl, child.wdl ? child.dtm + 1 : 0};
+            std::cout << describe(mover) << "\n";
+        }
+    }
+    TBResult best_result;
+    Move best = tablebase_move(board, best_result);
+    if (best != NULL_MOVE)
+        std::cout << "Best: " << move_to_string(best) << "\n";
+    return 0;
+}
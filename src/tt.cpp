@@ -0,0 +1,128 @@
+// tt.cpp
+#include "tt.hpp"
+#include <algorithm>
+
+TranspositionTable TT;
+
+namespace
+{
+    // Data word layout: move 16 | score 16 | eval 16 | depth 8 | bound 2 | generation 6
+    uint64_t pack(Move move, int score, int eval, int depth, int bound, int generation)
+    {
+        return static_cast<uint64_t>(move.data)
+             | static_cast<uint64_t>(static_cast<uint16_t>(score)) << 16
+             | static_cast<uint64_t>(static_cast<uint16_t>(eval)) << 32
+             | static_cast<uint64_t>(static_cast<uint8_t>(depth)) << 48
+             | static_cast<uint64_t>(bound) << 56
+             | static_cast<uint64_t>(generation) << 58;
+    }
+
+    Move data_move(uint64_t data) { Move move; move.data = static_cast<uint16_t>(data); return move; }
+    int data_score(uint64_t data) { return static_cast<int16_t>(data >> 16); }
+    int data_eval(uint64_t data) { return static_cast<int16_t>(data >> 32); }
+    int data_depth(uint64_t data) { return static_cast<uint8_t>(data >> 48); }
+    int data_bound(uint64_t data) { return (data >> 56) & 3; }
+    int data_generation(uint64_t data) { return data >> 58; }
+}
+
+void TranspositionTable::resize(size_t megabytes)
+{
+    size_t count = std::max<size_t>(1, (megabytes << 20) / sizeof(TTBucket));
+    if (count != bucket_count)
+    {
+        buckets.reset(new TTBucket[count]);
+        bucket_count = count;
+    }
+    clear();
+}
+
+void TranspositionTable::clear()
+{
+    for (size_t i = 0; i < bucket_count; ++i)
+    {
+        for (TTEntry& entry : buckets[i].entries)
+        {
+            entry.key_xor_data.store(0, std::memory_order_relaxed);
+            entry.data.store(0, std::memory_order_relaxed);
+        }
+    }
+    generation = 0;
+}
+
+void TranspositionTable::new_search()
+{
+    generation = (generation + 1) & 63;
+}
+
+bool TranspositionTable::probe(uint64_t key, TTData& result) const
+{
+    for (const TTEntry& entry : bucket_for(key).entries)
+    {
+        uint64_t data = entry.data.load(std::memory_order_relaxed);
+        if ((entry.key_xor_data.load(std::memory_order_relaxed) ^ data) == key && data_bound(data) != BOUND_NONE)
+        {
+            result.move = data_move(data);
+            result.score = data_score(data);
+            result.eval = data_eval(data);
+            result.depth = data_depth(data);
+            result.bound = data_bound(data);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TranspositionTable::store(uint64_t key, Move move, int score, int eval, int depth, int bound)
+{
+    TTBucket& bucket = bucket_for(key);
+    TTEntry* replace = nullptr;
+    int replace_value = 0;
+
+    for (TTEntry& entry : bucket.entries)
+    {
+        uint64_t data = entry.data.load(std::memory_order_relaxed);
+        if ((entry.key_xor_data.load(std::memory_order_relaxed) ^ data) == key)
+        {
+            // Same position: keep a deeper result from this search, and the old move if none is given
+            if (data_generation(data) == generation && bound != BOUND_EXACT && data_depth(data) > depth + 2)
+                return false;
+            if (move == NULL_MOVE)
+                move = data_move(data);
+            replace = &entry;
+            break;
+        }
+
+        // Depth-preferred with aging: each search of age counts as eight plies of depth
+        int age = (generation - data_generation(data)) & 63;
+        int value = data_bound(data) == BOUND_NONE ? -1000 : data_depth(data) - 8 * age;
+        if (!replace || value < replace_value)
+        {
+            replace = &entry;
+            replace_value = value;
+        }
+    }
+
+    uint64_t old = replace->data.load(std::memory_order_relaxed);
+    bool collision = data_bound(old) != BOUND_NONE && data_generation(old) == generation &&
+                     (replace->key_xor_data.load(std::memory_order_relaxed) ^ old) != key;
+
+    uint64_t data = pack(move, score, eval, depth, bound, generation);
+    replace->key_xor_data.store(key ^ data, std::memory_order_relaxed);
+    replace->data.store(data, std::memory_order_relaxed);
+    return collision;
+}
+
+int TranspositionTable::hashfull() const
+{
+    size_t samples = std::min<size_t>(bucket_count, 250);
+    int used = 0;
+    for (size_t i = 0; i < samples; ++i)
+    {
+        for (const TTEntry& entry : buckets[i].entries)
+        {
+            uint64_t data = entry.data.load(std::memory_order_relaxed);
+            used += data_bound(data) != BOUND_NONE && data_generation(data) == generation;
+        }
+    }
+    return samples ? static_cast<int>(used * 1000 / (samples * 4)) : 0;
+}
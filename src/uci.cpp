@@ -0,0 +1,338 @@
+// uci.cpp
+#include "uci.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "ai.hpp"
+#include "board.hpp"
+#include "book.hpp"
+#include "instrument.hpp"
+#include "movegen.hpp"
+#include "nnue.hpp"
+#include "search.hpp"
+#include "tablebase.hpp"
+#include "tt.hpp"
+
+namespace
+{
+    constexpr int64_t MOVE_OVERHEAD_MS = 30;    // GUI and pipe latency kept in reserve
+    constexpr int DEFAULT_MOVES_TO_GO = 30;
+    constexpr int MAX_THREADS = 256;
+    constexpr int MAX_HASH_MB = 65536;
+
+    // Output comes from both the input and the search thread; whole lines only
+    std::mutex output_mutex;
+
+    void send(const std::string& line)
+    {
+        std::lock_guard<std::mutex> lock(output_mutex);
+        std::cout << line << std::endl;
+    }
+
+    std::string score_string(int score)
+    {
+        if (score > MATE_BOUND)
+            return "mate " + std::to_string((MATE_SCORE - score + 1) / 2);
+        if (score < -MATE_BOUND)
+            return "mate -" + std::to_string((MATE_SCORE + score) / 2);
+        return "cp " + std::to_string(score);
+    }
+
+    std::string info_string(const SearchResult& result)
+    {
+        std::ostringstream line;
+        line << "info depth " << result.stats.depth << " score " << score_string(result.score)
+             << " nodes " << result.stats.nodes << " nps " << result.stats.nps
+             << " time " << static_cast<int64_t>(result.stats.seconds * 1000) << " hashfull " << result.stats.hashfull
+             << " tbhits " << result.stats.tb_hits
+             << " pv";
+        for (Move move : result.pv)
+            line << ' ' << move_to_string(move);
+        return line.str();
+    }
+
+    // Finds the legal move written in coordinate notation, e.g. e7e8q
+    Move parse_move(const Board& board, const std::string& text)
+    {
+        MoveList moves;
+        generate_legal_moves(board, moves);
+        for (Move move : moves)
+        {
+            if (move_to_string(move) == text)
+                return move;
+        }
+        return NULL_MOVE;
+    }
+
+    class UciEngine
+    {
+        public:
+            UciEngine() { board.initialize(); }
+            ~UciEngine() { stop_search(); }
+
+            void run();
+
+        private:
+            Board board{false};
+            int threads = 1;
+
+            std::thread search_thread;
+            std::atomic<bool> stop{false};
+            std::atomic<bool> pondering{false};
+            bool infinite = false;
+            std::mutex wait_mutex;
+            std::condition_variable wake;
+
+            void position(std::istringstream& input);
+            void go(std::istringstream& input);
+            void set_option(std::istringstream& input);
+            void stop_search();
+            void ponder_hit();
+    };
+
+    void UciEngine::run()
+    {
+        std::string line;
+        while (std::getline(std::cin, line))
+        {
+            std::istringstream input(line);
+            std::string command;
+            input >> command;
+
+            if (command == "uci")
+            {
+                send("id name chessEngine");
+                send("id author chessEngine developers");
+                send("option name Hash type spin default " + std::to_string(DEFAULT_HASH_MB) + " min 1 max " + std::to_string(MAX_HASH_MB));
+                send("option name Threads type spin default 1 min 1 max " + std::to_string(MAX_THREADS));
+                send("option name Ponder type check default false");
+                send("option name EvalFile type string default <empty>");
+                send("option name BookFile type string default <empty>");
+                send("option name TablebasePath type string default <empty>");
+                send("option name BestBookMove type check default false");
+                send("uciok");
+            }
+            else if (command == "isready")
+                send("readyok");
+            else if (command == "ucinewgame")
+            {
+                stop_search();
+                TT.clear();
+            }
+            else if (command == "position")
+            {
+                stop_search();
+                position(input);
+            }
+            else if (command == "go")
+                go(input);
+            else if (command == "stop")
+                stop_search();
+            else if (command == "ponderhit")
+                ponder_hit();
+            else if (command == "setoption")
+            {
+                stop_search();
+                set_option(input);
+            }
+            else if (command == "metrics")
+            {
+                // Not UCI: instrumentation counters as JSON, to a file when one is named
+                std::string path;
+                if (input >> path)
+                    instrument_dump_file(path);
+                else
+                {
+                    std::ostringstream json;
+                    instrument_dump(json);
+                    send(json.str());
+                }
+            }
+            else if (command == "quit")
+                break;
+        }
+        stop_search();
+    }
+
+    // position startpos|fen <fen> [moves m1 m2 ...]
+    void UciEngine::position(std::istringstream& input)
+    {
+        std::string token;
+        input >> token;
+        if (token == "startpos")
+        {
+            board.initialize();
+            input >> token;
+        }
+        else if (token == "fen")
+        {
+            std::string fen;
+            while (input >> token && token != "moves")
+                fen += token + " ";
+            if (!board.from_fen(fen))
+            {
+                send("info string invalid fen " + fen);
+                board.initialize();
+            }
+        }
+
+        // move_piece keeps the undo stack trimmed as a repetition history, however long the game
+        while (input >> token)
+        {
+            Move move = parse_move(board, token);
+            if (move == NULL_MOVE)
+            {
+                send("info string illegal move " + token);
+                break;
+            }
+            std::string from = index_to_chess(square_row(move.from()), square_col(move.from()));
+            std::string to = index_to_chess(square_row(move.to()), square_col(move.to()));
+            board.move_piece(from, to, move.is_promotion() ? "NBRQ"[move.promotion_type() - KNIGHT_WHITE] : 'Q');
+        }
+    }
+
+    void UciEngine::go(std::istringstream& input)
+    {
+        stop_search();
+
+        SearchLimits limits;
+        limits.threads = threads;
+        int64_t time_left[2] = {0, 0};
+        int64_t increment[2] = {0, 0};
+        int moves_to_go = 0;
+        int64_t move_time = 0;
+        bool ponder = false;
+        infinite = false;
+
+        std::string token;
+        while (input >> token)
+        {
+            if (token == "wtime") input >> time_left[WHITE];
+            else if (token == "btime") input >> time_left[BLACK];
+            else if (token == "winc") input >> increment[WHITE];
+            else if (token == "binc") input >> increment[BLACK];
+            else if (token == "movestogo") input >> moves_to_go;
+            else if (token == "movetime") input >> move_time;
+            else if (token == "depth") input >> limits.depth;
+            else if (token == "nodes") input >> limits.nodes;
+            else if (token == "infinite") infinite = true;
+            else if (token == "ponder") ponder = true;
+        }
+        limits.depth = std::clamp(limits.depth, 1, MAX_PLY - 1);
+
+        int us = color_index(board.get_turn());
+        if (move_time > 0)
+        {
+            limits.time_ms = std::max<int64_t>(1, move_time - MOVE_OVERHEAD_MS);
+            limits.soft_time_ms = limits.time_ms;
+        }
+        else if (!infinite && time_left[us] > 0)
+            limits.time_ms = allocate_time(time_left[us], increment[us], moves_to_go, limits.soft_time_ms);
+
+        stop = false;
+        pondering = ponder;
+        limits.stop = &stop;
+        limits.ponder = &pondering;
+        limits.on_iteration = [](const SearchResult& progress) { send(info_string(progress)); };
+
+        // The search works on a copy, so the input thread never touches a board in use
+        search_thread = std::thread([this, limits, position = board]() mutable
+        {
+            SearchResult result = select_best_move(position, limits);
+
+            // The GUI expects no bestmove while pondering or searching infinitely until told
+            {
+                std::unique_lock<std::mutex> lock(wait_mutex);
+                wake.wait(lock, [this]() { return stop.load() || (!pondering.load() && !infinite); });
+            }
+
+            std::string line = "bestmove " + (result.best_move == NULL_MOVE ? std::string("0000") : move_to_string(result.best_move));
+            if (result.pv.size() > 1)
+                line += " ponder " + move_to_string(result.pv[1]);
+            send(line);
+        });
+    }
+
+    void UciEngine::stop_search()
+    {
+        if (!search_thread.joinable())
+            return;
+        {
+            std::lock_guard<std::mutex> lock(wait_mutex);
+            stop = true;
+        }
+        wake.notify_all();
+        search_thread.join();
+    }
+
+    // The predicted move was played: the search goes on, now on the clock
+    void UciEngine::ponder_hit()
+    {
+        {
+            std::lock_guard<std::mutex> lock(wait_mutex);
+            pondering = false;
+        }
+        wake.notify_all();
+    }
+
+    // setoption name <name> value <value>
+    void UciEngine::set_option(std::istringstream& input)
+    {
+        std::string token, name, value;
+        input >> token;
+        while (input >> token && token != "value")
+            name += (name.empty() ? "" : " ") + token;
+        std::getline(input >> std::ws, value);
+
+        if (name == "Hash")
+            TT.resize(std::clamp(std::atoi(value.c_str()), 1, MAX_HASH_MB));
+        else if (name == "Threads")
+            threads = std::clamp(std::atoi(value.c_str()), 1, MAX_THREADS);
+        else if (name == "EvalFile" && !value.empty() && value != "<empty>")
+        {
+            if (nnue_load(value))
+                send("info string loaded network " + value);
+        }
+        else if (name == "BookFile")
+        {
+            if (value.empty() || value == "<empty>")
+                BOOK.close();
+            else if (BOOK.open(value))
+                send("info string loaded book " + value + " (" + std::to_string(BOOK.size()) + " entries)");
+            else
+                send("info string could not open book " + value);
+        }
+        else if (name == "TablebasePath")
+        {
+            TABLEBASES.close();
+            if (!value.empty() && value != "<empty>")
+                send("info string loaded " + std::to_string(TABLEBASES.load(value)) + " tablebases from " + value);
+        }
+        else if (name == "BestBookMove")
+            BOOK.set_selection(value == "true" ? BookSelection::Best : BookSelection::Weighted);
+    }
+}
+
+int64_t allocate_time(int64_t time_left, int64_t increment, int moves_to_go, int64_t& soft_ms)
+{
+    int64_t available = std::max<int64_t>(1, time_left - MOVE_OVERHEAD_MS);
+    int horizon = moves_to_go > 0 ? std::min(moves_to_go, 50) : DEFAULT_MOVES_TO_GO;
+    int64_t target = available / horizon + increment * 3 / 4;
+
+    // Never plan to use more than the clock allows, and allow overrunning the target threefold
+    int64_t hard_ms = std::min(target * 3, available * 4 / 5);
+    soft_ms = std::max<int64_t>(1, std::min(target, hard_ms));
+    return std::max<int64_t>(1, hard_ms);
+}
+
+int uci_loop()
+{
+    UciEngine engine;
+    engine.run();
+    return 0;
+}
@@ -1,59 +1,24 @@
 // validation.cpp
 #include "validation.hpp"
+#include "instrument.hpp"
+#include "movegen.hpp"
 
 // Determines if the player's king is in check
 bool is_check(const Board& board, int player)
 {
     // Check if any opposing piece is attacking the king
-    auto [king_x, king_y] = board.find_king_position(player);
-    if (king_x == -1 || king_y == -1) return false;
+    const Position& pos = board.get_position();
+    int king = pos.king_square(player);
+    if (king == NO_SQUARE) return false;
 
-    int opponent = -player;
-    for (int x = 0; x < 8; ++x)
-    {
-        for (int y = 0; y < 8; ++y)
-        {
-            if ((opponent == 1 && board.get_piece(x, y) > 0) || 
-                (opponent == -1 && board.get_piece(x, y) < 0))
-            {
-                auto moves = get_moves(x, y, board.get_board());
-                for (const auto& move : moves) {
-                    if (move.first == king_x && move.second == king_y)
-                    {
-                        return true;
-                    }
-                }
-            }
-        }
-    }
-    return false;
+    return is_square_attacked(pos, king, -player);
 }
 
 // Validates castling for kingside or queenside
 bool can_castle(const Board& board, int player, bool is_kingside)
 {
-    int row = (player == 1) ? 7 : 0;
-    int king_col = 4;
-    int rook_col = is_kingside ? 7 : 0;
-
-    // Check if king and rook are in the correct starting positions
-    if (board.get_piece(row, king_col) != (player == 1 ? KING_WHITE : KING_BLACK) ||
-        board.get_piece(row, rook_col) != (player == 1 ? ROOK_WHITE : ROOK_BLACK))
-        return false;
-
-    // Check if path between king and rook is clear
-    int step = is_kingside ? 1 : -1;
-    for (int col = king_col + step; col != rook_col; col += step)
-    {
-        if (board.get_piece(row, col) != EMPTY) {
-            return false;
-        }
-    }
-
-    // Ensure that neither the king nor the rook has moved, and king does not pass through check
-    // (Additional tracking needed to enforce this)
-
-    return !is_check(board, player);
+    // Rights, empty path and no attacked square on the king's way
+    return castling_allowed(board.get_position(), player, is_kingside);
 }
 
 // Determines if a pawn is in a promotion position
@@ -65,60 +30,31 @@ bool is_promotion(const Board& board, int x, int y)
     return false;
 }
 
+// Checks whether the side to move has any legal move
+static bool has_legal_move(const Board& board)
+{
+    MoveList moves;
+    generate_legal_moves(board, moves);
+    return !moves.empty();
+}
+
 // Checks if the player is in checkmate
 bool is_checkmate(const Board& board, int player)
 {
-    if (!board.is_in_check(player)) return false;
+    INSTRUMENT_SCOPE(Probe::IsCheckmate);
+    // has_legal_move looks at the side to move, so that must be the player
+    if (player != board.get_turn() || !board.is_in_check(player)) return false;
 
-    for (int x = 0; x < 8; ++x)
-	{
-        for (int y = 0; y < 8; ++y)
-		{
-            if ((player == 1 && board.get_piece(x, y) > 0) || 
-                (player == -1 && board.get_piece(x, y) < 0))
-			{
-                auto moves = get_moves(x, y, board.get_board());
-                for (const auto& move : moves)
-				{
-                    Board temp_board = board;
-                    temp_board.move_piece(index_to_chess(x, y), index_to_chess(move.first, move.second));
-                    if (!temp_board.is_in_check(player))
-					{
-                        return false;
-                    }
-                }
-            }
-        }
-    }
-    return true;
+    return !has_legal_move(board);
 }
 
 // Checks if the player is in stalemate
 bool is_stalemate(const Board& board, int player)
 {
-    if (board.is_in_check(player)) return false;
+    INSTRUMENT_SCOPE(Probe::IsStalemate);
+    if (player != board.get_turn() || board.is_in_check(player)) return false;
 
-    for (int x = 0; x < 8; ++x)
-	{
-        for (int y = 0; y < 8; ++y)
-		{
-            if ((player == 1 && board.get_piece(x, y) > 0) || 
-                (player == -1 && board.get_piece(x, y) < 0))
-			{
-                auto moves = get_moves(x, y, board.get_board());
-                for (const auto& move : moves)
-				{
-                    Board temp_board = board;
-                    temp_board.move_piece(index_to_chess(x, y), index_to_chess(move.first, move.second));
-                    if (!temp_board.is_in_check(player))
-					{
-                        return false;
-                    }
-                }
-            }
-        }
-    }
-    return true;
+    return !has_legal_move(board);
 }
 
 bool is_insufficient_material(const Board& board)